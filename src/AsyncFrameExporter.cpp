@@ -0,0 +1,110 @@
+#include "AsyncFrameExporter.h"
+
+#include <cassert>
+
+#include "Simulation.h"
+#include "SimulationRunner.h"
+
+AsyncFrameExporter::AsyncFrameExporter(std::size_t num_buffers, 
+        FrameOverflowPolicy policy):
+        m_buffers(num_buffers), m_policy(policy) {
+    assert(num_buffers > 0);
+    m_thread = std::thread([this]() {run();});
+}
+ 
+AsyncFrameExporter::~AsyncFrameExporter() {
+    m_connection = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_frame_ready.notify_one();
+    m_thread.join();
+}
+ 
+void AsyncFrameExporter::add_consumer(Consumer consumer) {
+    std::lock_guard<std::mutex> lock(m_consumer_mutex);
+    m_consumers.push_back(std::move(consumer));
+}
+ 
+void AsyncFrameExporter::attach(SimulationRunner& runner) {
+    m_connection = std::make_unique<ScopedEventConnection>(runner.on_frame_end(
+        [this](Simulation& simulation, SimulationRunner&) {
+            capture(simulation);
+        }));
+}
+ 
+void AsyncFrameExporter::capture(const Simulation& simulation) {
+    std::size_t frame_idx;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(m_captured - m_consumed == m_buffers.size()) {
+            if(m_policy == FrameOverflowPolicy::Drop) {
+                ++m_dropped;
+                return;
+            }
+            m_buffer_free.wait(lock, [this]() {
+                return m_captured - m_consumed < m_buffers.size();
+            });
+        }
+        frame_idx = m_captured;
+    }
+
+    //The buffer is not visible to the consumer thread until the frame is
+    //published below, so it can be filled without holding the lock.
+    auto& frame = m_buffers[frame_idx % m_buffers.size()];
+    auto& grid = simulation.get_particles();
+    auto count = grid.num_particles();
+    frame.time = simulation.simulation_time().current_simulation_time();
+    frame.frame_count = simulation.simulation_time().frame_count();
+    frame.ids.resize(count);
+    frame.positions.resize(count);
+    frame.velocities.resize(count);
+    std::size_t i = 0;
+    for(auto& item : grid) {
+        frame.ids[i] = item.id();
+        frame.positions[i] = item.position();
+        frame.velocities[i] = item.velocity();
+        ++i;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_captured;
+    }
+    m_frame_ready.notify_one();
+}
+ 
+void AsyncFrameExporter::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_buffer_free.wait(lock, [this]() {return m_consumed == m_captured;});
+}
+ 
+std::size_t AsyncFrameExporter::dropped_frames() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
+ 
+void AsyncFrameExporter::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true) {
+        m_frame_ready.wait(lock, [this]() {
+            return m_stopping || m_consumed < m_captured;
+        });
+        if(m_consumed == m_captured) {
+            return;
+        }
+
+        auto& frame = m_buffers[m_consumed % m_buffers.size()];
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> consumer_lock(m_consumer_mutex);
+            for(auto& consumer : m_consumers) {
+                consumer(frame);
+            }
+        }
+        lock.lock();
+        ++m_consumed;
+        m_buffer_free.notify_all();
+    }
+}
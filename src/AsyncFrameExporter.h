@@ -0,0 +1,91 @@
+#ifndef PS_ASYNC_FRAME_EXPORTER_H_
+#define PS_ASYNC_FRAME_EXPORTER_H_
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CommonTypes.h"
+#include "Event.h"
+#include "Vector2.h"
+
+class Simulation;
+class SimulationRunner;
+
+enum class FrameOverflowPolicy {
+    //The simulation waits until a buffer is free.
+    Block,
+    //The frame is skipped and counted in dropped_frames().
+    Drop
+};
+
+//Copy of the particle state at the end of a frame, in grid order.
+struct FrameSnapshot {
+    double time = 0.0;
+    std::size_t frame_count = 0;
+    std::vector<int> ids;
+    std::vector<SpatialVector> positions;
+    std::vector<SpatialVector> velocities;
+};
+
+//Hands copies of finished frames to consumers running on a thread of their
+//own. Frames are copied into a ring of buffers that are reused once
+//consumed, so buffers only allocate while the particle count grows. The
+//simulation thread only waits when every buffer is still queued, and never
+//under the Drop policy.
+class AsyncFrameExporter {
+public:
+    using Consumer = std::function<void (const FrameSnapshot&)>;
+
+    explicit AsyncFrameExporter(std::size_t num_buffers = 3, 
+            FrameOverflowPolicy policy = FrameOverflowPolicy::Block);
+    //Delivers the frames still queued before stopping the thread.
+    ~AsyncFrameExporter();
+
+    AsyncFrameExporter(const AsyncFrameExporter& other) = delete;
+    AsyncFrameExporter(AsyncFrameExporter&& other) noexcept = delete;
+    AsyncFrameExporter& operator =(const AsyncFrameExporter& other) = delete;
+    AsyncFrameExporter& operator =(AsyncFrameExporter&& other) noexcept = delete;
+
+    //Consumers are called on the exporter thread in the order they were
+    //added, one frame at a time.
+    void add_consumer(Consumer consumer);
+
+    //Captures the end of every frame the runner completes.
+    void attach(SimulationRunner& runner);
+
+    void capture(const Simulation& simulation);
+    //Waits until every captured frame was consumed.
+    void flush();
+
+    FrameOverflowPolicy policy() const {return m_policy;}
+    std::size_t num_buffers() const {return m_buffers.size();}
+    std::size_t dropped_frames() const;
+
+private:
+    void run();
+
+    std::vector<FrameSnapshot> m_buffers;
+    FrameOverflowPolicy m_policy;
+
+    //Frames are taken from the ring in capture order, and the buffer of
+    //frame n is m_buffers[n % num_buffers()].
+    mutable std::mutex m_mutex;
+    std::condition_variable m_frame_ready;
+    std::condition_variable m_buffer_free;
+    std::size_t m_captured = 0;
+    std::size_t m_consumed = 0;
+    std::size_t m_dropped = 0;
+    bool m_stopping = false;
+
+    std::mutex m_consumer_mutex;
+    std::vector<Consumer> m_consumers;
+
+    std::unique_ptr<ScopedEventConnection> m_connection;
+    std::thread m_thread;
+};
+
+#endif
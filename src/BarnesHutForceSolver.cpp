@@ -0,0 +1,154 @@
+#include "BarnesHutForceSolver.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "Grid.h"
+
+BarnesHutForceSolver::BarnesHutForceSolver(PositionType theta, int leaf_capacity):
+    m_theta(theta), m_leaf_capacity(leaf_capacity) {
+    assert(m_leaf_capacity > 0);
+}
+ 
+void BarnesHutForceSolver::prepare_frame(const Simulation& simulation, 
+        const Grid& grid) {
+    m_nodes.clear();
+    m_node_particles.clear();
+    m_node_store->clear();
+    m_items.clear();
+    m_items.reserve(grid.num_particles());
+
+    for(auto& item : grid) {
+        m_items.push_back(&item.particle());
+    }
+
+    Node root;
+    root.min_corner = SpatialVector::zero();
+    root.size = std::max(grid.width(), grid.height());
+    root.begin = 0;
+    root.end = m_items.size();
+    m_nodes.push_back(std::move(root));
+
+    build_node(0, 0);
+
+    //Aggregate particles are materialized once per frame rather than on every
+    //far-field evaluation.
+    m_node_particles.reserve(m_nodes.size());
+    m_node_store->reserve(m_nodes.size());
+    for(auto& node : m_nodes) {
+        m_node_particles.push_back(node.aggregate.make_particle(*m_node_store));
+    }
+}
+ 
+const ParticleAggregate& BarnesHutForceSolver::build_node(std::size_t node_idx, 
+        int depth) {
+    auto begin = m_nodes[node_idx].begin;
+    auto end = m_nodes[node_idx].end;
+
+    if(end - begin <= static_cast<std::size_t>(m_leaf_capacity) 
+            || depth >= MAX_DEPTH) {
+        auto& node = m_nodes[node_idx];
+        for(auto i = begin; i < end; ++i) {
+            node.aggregate.add(*m_items[i]);
+        }
+        return node.aggregate;
+    }
+
+    auto half = m_nodes[node_idx].size * PositionType(0.5);
+    auto mid = m_nodes[node_idx].min_corner + SpatialVector(half, half);
+
+    //Partition the item range into the four quadrants in place so every node
+    //owns a contiguous slice of m_items.
+    auto items_begin = m_items.begin() + begin;
+    auto items_end = m_items.begin() + end;
+    auto y_split = std::partition(items_begin, items_end, 
+        [&mid](const Particle* p) {return p->position().y < mid.y;});
+    auto x_split_low = std::partition(items_begin, y_split, 
+        [&mid](const Particle* p) {return p->position().x < mid.x;});
+    auto x_split_high = std::partition(y_split, items_end, 
+        [&mid](const Particle* p) {return p->position().x < mid.x;});
+
+    std::size_t bounds[5] = {
+        begin,
+        static_cast<std::size_t>(x_split_low - m_items.begin()),
+        static_cast<std::size_t>(y_split - m_items.begin()),
+        static_cast<std::size_t>(x_split_high - m_items.begin()),
+        end
+    };
+
+    auto first_child = static_cast<int>(m_nodes.size());
+    auto min_corner = m_nodes[node_idx].min_corner;
+    m_nodes[node_idx].first_child = first_child;
+
+    for(int i = 0; i < 4; ++i) {
+        Node child;
+        child.min_corner = min_corner + SpatialVector(
+                (i % 2) * half, (i / 2) * half);
+        child.size = half;
+        child.begin = bounds[i];
+        child.end = bounds[i+1];
+        m_nodes.push_back(std::move(child));
+    }
+
+    ParticleAggregate aggregate;
+    for(int i = 0; i < 4; ++i) {
+        if(m_nodes[first_child + i].begin != m_nodes[first_child + i].end) {
+            aggregate.merge(build_node(first_child + i, depth + 1));
+        }
+    }
+    m_nodes[node_idx].aggregate = std::move(aggregate);
+    return m_nodes[node_idx].aggregate;
+}
+ 
+ForceType BarnesHutForceSolver::compute_force(const Particle& particle, 
+        const SpatialVector& position, const SpatialVector& velocity,
+        const Simulation& simulation, const Grid& grid) const {
+    auto force = AccumulatorVector::zero();
+    if(m_nodes.empty()) {
+        return ForceType(force);
+    }
+
+    auto theta_squared = m_theta * m_theta;
+    auto& interactions = grid.interactions();
+
+    std::size_t stack[4 * MAX_DEPTH + 4];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while(stack_size > 0) {
+        auto& node = m_nodes[stack[--stack_size]];
+        if(node.begin == node.end) {
+            continue;
+        }
+
+        if(node.is_leaf()) {
+            for(auto i = node.begin; i < node.end; ++i) {
+                auto target = m_items[i];
+                if(target == &particle) continue;
+                force += AccumulatorVector(
+                    interactions.interaction_between(particle, *target)
+                    .compute_force(*target, particle, 
+                        grid.nearest_image(position, target->position()), velocity));
+            }
+            continue;
+        }
+
+        auto& node_particle = m_node_particles[&node - m_nodes.data()];
+        auto image = grid.nearest_image(position, node_particle.position());
+        auto dist_squared = 
+            (node_particle.position() - image).magnitude_squared();
+
+        //Aggregates have no type, so the particle's own interaction applies.
+        if(!node.contains(particle.position()) 
+                && node.size * node.size < theta_squared * dist_squared) {
+            force += AccumulatorVector(
+                    particle.compute_force(node_particle, image, velocity));
+        } else {
+            for(int i = 0; i < 4; ++i) {
+                stack[stack_size++] = node.first_child + i;
+            }
+        }
+    }
+
+    return ForceType(force);
+}
@@ -0,0 +1,70 @@
+#ifndef BARNESHUTFORCESOLVER_H_
+#define BARNESHUTFORCESOLVER_H_
+
+#include <memory>
+#include <vector>
+
+#include "IForceSolver.h"
+#include "Particle.h"
+#include "ParticleAggregate.h"
+
+//Approximates long range forces with a quadtree rebuilt every frame. Nodes
+//that appear smaller than theta (node size / distance) are evaluated through
+//a single aggregate particle, giving O(N log N) force evaluation.
+class BarnesHutForceSolver: public IForceSolver {
+public:
+    BarnesHutForceSolver(PositionType theta = 0.5, int leaf_capacity = 8);
+    virtual ~BarnesHutForceSolver() = default;
+
+    BarnesHutForceSolver(const BarnesHutForceSolver& other) = delete;
+    BarnesHutForceSolver(BarnesHutForceSolver&& other) noexcept = default;
+    BarnesHutForceSolver& operator =(const BarnesHutForceSolver& other) = delete;
+    BarnesHutForceSolver& operator =(BarnesHutForceSolver&& other) noexcept = default;
+
+    virtual void prepare_frame(const Simulation& simulation, 
+            const Grid& grid) override;
+
+    virtual ForceType compute_force(const Particle& particle, 
+            const SpatialVector& position, const SpatialVector& velocity,
+            const Simulation& simulation, const Grid& grid) const override;
+
+    PositionType theta() const {return m_theta;}
+    void set_theta(PositionType value) {m_theta = value;}
+    int leaf_capacity() const {return m_leaf_capacity;}
+    void set_leaf_capacity(int value) {m_leaf_capacity = value;}
+
+    std::size_t num_nodes() const {return m_nodes.size();}
+
+private:
+    static constexpr int MAX_DEPTH = 32;
+
+    struct Node {
+        SpatialVector min_corner;
+        PositionType size;
+        std::size_t begin;
+        std::size_t end;
+        //Index of the first of four consecutive children, or -1 for leaves.
+        int first_child = -1;
+        ParticleAggregate aggregate;
+
+        bool is_leaf() const {return first_child < 0;}
+        bool contains(const SpatialVector& pos) const {
+            return pos.x >= min_corner.x && pos.y >= min_corner.y 
+                && pos.x < min_corner.x + size && pos.y < min_corner.y + size;
+        }
+    };
+
+    const ParticleAggregate& build_node(std::size_t node_idx, int depth);
+
+    std::vector<Node> m_nodes;
+    std::vector<Particle> m_node_particles;
+    //State of m_node_particles, held by pointer since they refer to it.
+    std::unique_ptr<ParticleStore> m_node_store = 
+        std::make_unique<ParticleStore>();
+    std::vector<const Particle*> m_items;
+
+    PositionType m_theta = 0.5;
+    int m_leaf_capacity = 8;
+};
+
+#endif
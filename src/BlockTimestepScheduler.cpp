@@ -0,0 +1,84 @@
+#include "BlockTimestepScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "Particle.h"
+
+BlockTimestepScheduler::BlockTimestepScheduler(int max_level, double accuracy):
+    m_max_level(max_level), m_accuracy(accuracy) {
+    assert(max_level >= 0 && max_level < 16);
+}
+ 
+int BlockTimestepScheduler::level_of(const Particle& particle) const {
+    auto level = particle.timestep_level();
+    return level < 0 ? m_max_level : std::min(level, m_max_level);
+}
+ 
+int BlockTimestepScheduler::boundary_level(std::size_t substep) const {
+    auto level = m_max_level;
+    while(level > 0 && substep % stride(level - 1) == 0) {
+        --level;
+    }
+    return level;
+}
+ 
+void BlockTimestepScheduler::assign_level(Particle& particle,
+        std::size_t substep, double base_time_step) const {
+    if(particle.timestep_level() < 0) {
+        particle.set_timestep_level(m_max_level);
+        return;
+    }
+
+    auto current = level_of(particle);
+    //Refining is always possible at a boundary of the current level.
+    //Coarsening goes one level at a time and waits until the longer step
+    //can start here.
+    auto level = std::max(desired_level(particle, base_time_step), current - 1);
+    while(level < current && substep % stride(level) != 0) {
+        ++level;
+    }
+    particle.set_timestep_level(level);
+}
+ 
+int BlockTimestepScheduler::desired_level(const Particle& particle,
+        double base_time_step) const {
+    //Called right after the end of step acceleration was cached, so the
+    //delta covers the particle's last step.
+    auto dt = time_step(level_of(particle), base_time_step);
+    double jerk = particle.delta_acceleration().magnitude() / dt;
+    double acceleration = particle.current_acceleration().magnitude();
+    if(jerk <= 0) {
+        return 0;
+    }
+
+    auto target_dt = m_accuracy * acceleration / jerk;
+    if(target_dt >= base_time_step) {
+        return 0;
+    }
+    auto level = static_cast<int>(std::ceil(std::log2(base_time_step / target_dt)));
+    return std::min(level, m_max_level);
+}
+ 
+void BlockTimestepScheduler::begin_frame() {
+    m_frame = BlockTimestepStatistics();
+    m_frame_population = 0;
+    m_frame_finest_level = 0;
+}
+ 
+void BlockTimestepScheduler::record_substep(std::size_t active,
+        std::size_t population, int finest_level) {
+    m_frame.particle_updates += active;
+    m_frame_population = std::max(m_frame_population, population);
+    m_frame_finest_level = std::max(m_frame_finest_level, finest_level);
+}
+ 
+void BlockTimestepScheduler::end_frame() {
+    auto uniform_updates = m_frame_population << m_frame_finest_level;
+    m_frame.updates_saved = uniform_updates > m_frame.particle_updates
+        ? uniform_updates - m_frame.particle_updates : 0;
+
+    m_total.particle_updates += m_frame.particle_updates;
+    m_total.updates_saved += m_frame.updates_saved;
+}
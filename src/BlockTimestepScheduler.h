@@ -0,0 +1,77 @@
+#ifndef PS_BLOCKTIMESTEPSCHEDULER_H_
+#define PS_BLOCKTIMESTEPSCHEDULER_H_
+
+#include <cstddef>
+
+class Particle;
+
+struct BlockTimestepStatistics {
+    //End of step force evaluations that were carried out.
+    std::size_t particle_updates = 0;
+    //Evaluations avoided compared to stepping every particle with the
+    //shortest time step in use.
+    std::size_t updates_saved = 0;
+};
+
+//Hierarchical block time steps. A particle on level k advances with
+//base_time_step / 2^k, so a frame is divided into 2^max_level sub-steps and
+//a particle only has its forces evaluated at the sub-steps where its own
+//step ends. Levels follow the time scale |a| / |da/dt| and only change at
+//step boundaries shared with the new level.
+class BlockTimestepScheduler {
+public:
+    BlockTimestepScheduler(int max_level = 4, double accuracy = 0.03);
+    ~BlockTimestepScheduler() = default;
+
+    BlockTimestepScheduler(const BlockTimestepScheduler& other) = default;
+    BlockTimestepScheduler(BlockTimestepScheduler&& other) noexcept = default;
+    BlockTimestepScheduler& operator =(const BlockTimestepScheduler& other) = default;
+    BlockTimestepScheduler& operator =(BlockTimestepScheduler&& other) noexcept = default;
+
+    int max_level() const {return m_max_level;}
+    double accuracy() const {return m_accuracy;}
+
+    //Sub-steps are counted in units of the finest level's step.
+    std::size_t substeps() const {return std::size_t(1) << m_max_level;}
+    std::size_t stride(int level) const {
+        return std::size_t(1) << (m_max_level - level);
+    }
+    double time_step(int level, double base_time_step) const {
+        return base_time_step / (std::size_t(1) << level);
+    }
+
+    //Particles without a level run on the finest one until their first
+    //step completes.
+    int level_of(const Particle& particle) const;
+    bool is_step_boundary(const Particle& particle, std::size_t substep) const {
+        return substep % stride(level_of(particle)) == 0;
+    }
+    //Coarsest level whose steps begin or end at the given sub-step.
+    int boundary_level(std::size_t substep) const;
+
+    //Picks the level for the step starting at substep from the acceleration
+    //change over the step that just ended.
+    void assign_level(Particle& particle, std::size_t substep,
+            double base_time_step) const;
+
+    void begin_frame();
+    void record_substep(std::size_t active, std::size_t population,
+            int finest_level);
+    void end_frame();
+
+    const BlockTimestepStatistics& frame_statistics() const {return m_frame;}
+    const BlockTimestepStatistics& total_statistics() const {return m_total;}
+
+private:
+    int desired_level(const Particle& particle, double base_time_step) const;
+
+    int m_max_level;
+    double m_accuracy;
+
+    BlockTimestepStatistics m_frame;
+    BlockTimestepStatistics m_total;
+    std::size_t m_frame_population = 0;
+    int m_frame_finest_level = 0;
+};
+
+#endif
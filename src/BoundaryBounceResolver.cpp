@@ -1,6 +1,9 @@
 #include "BoundaryBounceResolver.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
 
 #include "Grid.h"
 #include "Simulation.h"
@@ -10,208 +13,125 @@
 
 using namespace tracing;
 
-BoundaryBounceResolver::BoundaryBounceResolver(PositionType bounce_coefficient,
-        int division_levels):
-    m_bounce_coeff(bounce_coefficient), m_division_levels(division_levels) {}
- 
-void BoundaryBounceResolver::resolve_border_collision(Simulation& simulation, 
-        Grid& grid, Particle& particle, SpatialVector& acceleration) const {
-    double dt = simulation.simulation_time().time_delta();
-    double remaining_time = dt;     
-
-    resolve_border_collision_recursive(simulation, grid, particle, acceleration,
-            remaining_time);
-
-    assert(remaining_time <= 0);
-
-    PARTICLE_TRACER_EVENT(simulation.tracer(), TraceEventType::CollisionEnergyLoss,
-        particle, &simulation, simulation.simulation_time());
-
-    PARTICLE_MOTION_TRACER_EVENT(simulation.tracer(), 
-            TraceEventType::MotionParamsUpdated, particle,
-        &simulation, simulation.simulation_time(), 0.0, acceleration, ( 
-            [this, &particle]() {
-                particle.update_velocity(particle.next_velocity() * m_bounce_coeff);
-            }
-        ));
-}
- 
-void BoundaryBounceResolver::resolve_border_collision_recursive(Simulation& simulation, 
-        Grid& grid, Particle& particle, SpatialVector& acceleration, 
-        double& remaining_time, int recursion_count) const {
-    assert(recursion_count < 10);
-
-    double start_rem_time = remaining_time;
-
-    auto next_position = particle.next_position();
-    auto next_velocity = particle.next_velocity();
-    auto acc = acceleration;
-
-    auto results = boundary_collision_subdivide(simulation, 
-        particle, grid, acc, remaining_time, next_position,
-        next_velocity);    
+namespace {
 
-    double end_dt = results.end_time;
+constexpr double NO_CROSSING = std::numeric_limits<double>::infinity();
 
-    simulation.simulate_motion(particle, end_dt, acc, 
-        next_position, next_velocity);
+//Earliest time in [0, max_time] at which x + v*t + a*t^2/2 reaches wall while
+//moving outwards, where outwards is the sign of direction. Roots where the
+//coordinate is heading back inside, such as the wall it just bounced off,
+//are skipped.
+double crossing_time(double x, double v, double a, double wall,
+        double direction, double max_time) {
+    double roots[2];
+    int num_roots = 0;
+    auto c = x - wall;
 
-    remaining_time -= end_dt;
-
-
-    auto result = 
-        interpolate_to_boundary(
-            simulation, particle, grid, remaining_time, next_position,
-            next_velocity);
-    std::tie(next_position, next_velocity) = result;
-
-    PARTICLE_MOTION_TRACER_EVENT(simulation.tracer(), 
-            TraceEventType::MotionParamsUpdated, particle,
-        &simulation, simulation.simulation_time(), start_rem_time-remaining_time, 
-        acceleration, ( 
-            [&particle, &next_position, &next_velocity]() {
-                particle.update_position(next_position);
-                particle.update_velocity(next_velocity);
-            }
-        ));
-
-    if(remaining_time >= 0) {
-        if(!try_simulate_remainder(simulation, particle, grid, acceleration, 
-                remaining_time, next_position, next_velocity)) {
-            resolve_border_collision_recursive(simulation, grid, particle,
-                acceleration, remaining_time, recursion_count+1);
+    if(a == 0) {
+        if(v != 0) {
+            roots[num_roots++] = -c / v;
         }
-    }
-}
- 
-bool BoundaryBounceResolver::try_simulate_remainder(Simulation& simulation, 
-        Particle& particle, Grid& grid, SpatialVector& acceleration, 
-        double& remaining_time, const SpatialVector& start_pos, 
-        const SpatialVector& start_vel) const {
- 
-    auto start_time = remaining_time;
-    auto test_pos = start_pos;
-    auto test_vel = start_vel;
-
-    simulation.simulate_motion(particle, remaining_time, acceleration, 
-            test_pos, test_vel);
-
-    if(!grid.is_point_within(test_pos)) {
-        remaining_time = start_time;
-        return false;
     } else {
-        PARTICLE_TRACER_EVENT(simulation.tracer(), TraceEventType::SimulateRemainder,
-            particle, &simulation, simulation.simulation_time());
-
-        PARTICLE_MOTION_TRACER_EVENT(simulation.tracer(), 
-                TraceEventType::MotionParamsUpdated, particle,
-            &simulation, simulation.simulation_time(), remaining_time, acceleration, ( 
-                [this, &particle, &test_pos, &test_vel]() {
-                    particle.update_position(test_pos);
-                    particle.update_velocity(test_vel);
-                }
-            ));
-        remaining_time = 0.0; 
-
-        return true;
-    }
-}
-
-std::tuple<SpatialVector, SpatialVector> 
-    BoundaryBounceResolver::interpolate_to_boundary(Simulation& simulation, 
-        Particle& particle, Grid& grid, double& remaining_time, 
-        const SpatialVector& start_pos, const SpatialVector& start_vel) const {
-     
-    auto next_position = start_pos;
-    auto next_velocity = start_vel;
-
-    double x_time;
-    double y_time;
-
-    if(next_velocity.x < 0) {
-        x_time = -next_position.x / next_velocity.x;
-    } else {
-        x_time = (grid.width() - next_position.x) / next_velocity.x;
-    }
-
-    if(next_velocity.y < 0) {
-        y_time = -next_position.y / next_velocity.y;
-    } else {
-        y_time = (grid.height() - next_position.y) / next_velocity.y;
-    }
-
-    if(std::abs(x_time) < std::abs(y_time)) {
-        if(x_time > remaining_time) {
-            x_time = remaining_time;
+        auto discriminant = v*v - 2*a*c;
+        if(discriminant < 0) {
+            return NO_CROSSING;
         }
-        remaining_time -= x_time;
-        next_position += PositionType(x_time)*next_velocity;
-
-        if(next_velocity.x < 0) {
-            next_position.x = 0.0;
+        //Avoids the cancellation of the textbook formula.
+        auto q = -0.5 * (v + std::copysign(std::sqrt(discriminant), v));
+        if(q == 0) {
+            roots[num_roots++] = 0;
         } else {
-            next_position.x = grid.width() - 1e-6;
-        }
-
-        next_velocity.x = -next_velocity.x;
-
-    } else {
-        if(y_time > remaining_time) {
-            y_time = remaining_time;
+            roots[num_roots++] = q / (0.5 * a);
+            roots[num_roots++] = c / q;
         }
-        remaining_time -= y_time;
-        next_position += PositionType(y_time)*next_velocity;
+    }
 
-        if(next_velocity.y < 0) {
-            next_position.y = 0.0;
-        } else {
-            next_position.y = grid.height() - 1e-6;
+    auto best = NO_CROSSING;
+    for(int i = 0; i < num_roots; ++i) {
+        auto t = roots[i];
+        if(t >= 0 && t <= max_time && t < best && direction * (v + a*t) > 0) {
+            best = t;
         }
-
-        next_velocity.y = -next_velocity.y;
     }
-    next_position = grid.clip_outer_boundary(next_position);
-
-    assert(grid.is_point_within(next_position));
-
-    return std::make_tuple(next_position, next_velocity);
+    return best;
 }
 
-SubdivideResults BoundaryBounceResolver::boundary_collision_subdivide(
-        Simulation& simulation, Particle& particle, Grid& grid, 
-        SpatialVector& acceleration, double& remaining_time, 
-        const SpatialVector& position, const SpatialVector& velocity) const {
-    double end_dt = 0.0;
-    double next_dt = 0.0;
-    double current_min_time = 0.0;
-    double current_max_time = remaining_time;
-
-    auto next_position = particle.next_position();
-    auto next_velocity = particle.next_velocity();
+}
 
-    for(int i = 0; i < m_division_levels; ++i) {
-        next_position = particle.next_position();
-        next_velocity = particle.next_velocity();
+BoundaryBounceResolver::BoundaryBounceResolver(PositionType bounce_coefficient):
+    m_bounce_coeff(bounce_coefficient) {}
+ 
+void BoundaryBounceResolver::resolve_border_collision(Simulation& simulation,
+        Grid& grid, Particle& particle, SpatialVector& acceleration) const {
+    using Vector2d = Vector2<double>;
 
-        next_dt = (current_max_time + current_min_time) * 0.5;
-        simulation.simulate_motion(particle, next_dt, acceleration, 
-                next_position, next_velocity);
+    double dt = simulation.simulation_time().time_delta();
+    double remaining_time = dt;
+
+    auto position = Vector2d(particle.next_position());
+    auto velocity = Vector2d(particle.next_velocity());
+    auto acc = Vector2d(acceleration);
+    //Largest coordinates that still count as inside the grid.
+    Vector2d upper(std::nextafter(grid.width(), PositionType(0)),
+            std::nextafter(grid.height(), PositionType(0)));
+
+    auto advance = [&position, &velocity, &acc](double t) {
+        position += velocity * t + acc * (0.5 * t * t);
+        velocity += acc * t;
+    };
+
+    for(int bounce = 0; bounce < MAX_BOUNCES && remaining_time > 0; ++bounce) {
+        double times[4] = {
+            crossing_time(position.x, velocity.x, acc.x, 0, -1, remaining_time),
+            crossing_time(position.x, velocity.x, acc.x, grid.width(), 1,
+                    remaining_time),
+            crossing_time(position.y, velocity.y, acc.y, 0, -1, remaining_time),
+            crossing_time(position.y, velocity.y, acc.y, grid.height(), 1,
+                    remaining_time)
+        };
+        auto wall = std::min_element(times, times + 4) - times;
+        if(times[wall] == NO_CROSSING) {
+            advance(remaining_time);
+            remaining_time = 0;
+            break;
+        }
 
-        if(!grid.is_point_within(next_position)) {
-            current_max_time = next_dt; 
-        } else {
-            current_min_time = next_dt; 
+        advance(times[wall]);
+        remaining_time -= times[wall];
+        switch(wall) {
+        case 0: position.x = 0; velocity.x = -velocity.x; break;
+        case 1: position.x = grid.width(); velocity.x = -velocity.x; break;
+        case 2: position.y = 0; velocity.y = -velocity.y; break;
+        case 3: position.y = grid.height(); velocity.y = -velocity.y; break;
         }
-        end_dt = (current_max_time + current_min_time) * 0.5;
     }
 
-    SubdivideResults results;
-    results.end_time = end_dt;
-    results.min_time = current_min_time;
-    results.max_time = current_max_time;
-    results.final_pos = next_position;
-    results.final_vel = next_velocity;
+    //Rounding can leave the particle just past a wall, and the upper walls
+    //themselves lie outside the grid.
+    position.x = std::min(std::max(position.x, 0.0), upper.x);
+    position.y = std::min(std::max(position.y, 0.0), upper.y);
+    auto final_position = SpatialVector(position);
+    auto final_velocity = SpatialVector(velocity);
+    assert(grid.is_point_within(final_position));
+
+    PARTICLE_MOTION_TRACER_EVENT(simulation.tracer(),
+            TraceEventType::MotionParamsUpdated, particle,
+        &simulation, simulation.simulation_time(), dt - remaining_time,
+        acceleration, (
+            [&particle, &final_position, &final_velocity]() {
+                particle.update_position(final_position);
+                particle.update_velocity(final_velocity);
+            }
+        ));
+
+    PARTICLE_TRACER_EVENT(simulation.tracer(), TraceEventType::CollisionEnergyLoss,
+        particle, &simulation, simulation.simulation_time());
 
-    return results;
+    PARTICLE_MOTION_TRACER_EVENT(simulation.tracer(),
+            TraceEventType::MotionParamsUpdated, particle,
+        &simulation, simulation.simulation_time(), 0.0, acceleration, (
+            [this, &particle]() {
+                particle.update_velocity(particle.next_velocity() * m_bounce_coeff);
+            }
+        ));
 }
- 
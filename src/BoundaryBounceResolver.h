@@ -3,22 +3,18 @@
 
 #include "IBoundaryCollisionResolver.h"
 
-#include <tuple>
-
 #include "CommonTypes.h"
 
-struct SubdivideResults {
-    double min_time;
-    double max_time;
-    double end_time;
-    SpatialVector final_pos;
-    SpatialVector final_vel;
-};
-
+//Bounces particles off the grid walls. The crossing times are solved
+//analytically for motion under the constant acceleration of the step, so no
+//forces are evaluated while resolving a collision.
 class BoundaryBounceResolver: public IBoundaryCollisionResolver {
 public:
-    BoundaryBounceResolver(PositionType bounce_coefficient = 1.0,
-        int division_levels=3);
+    //Bounces resolved within one step before the particle is left resting
+    //on the wall for the rest of it.
+    static constexpr int MAX_BOUNCES = 16;
+
+    BoundaryBounceResolver(PositionType bounce_coefficient = 1.0);
     virtual ~BoundaryBounceResolver() = default;
 
     BoundaryBounceResolver(const BoundaryBounceResolver& other) = delete;
@@ -33,31 +29,7 @@ public:
     void set_bounce_coefficient(PositionType value) {m_bounce_coeff = value;}
 
 private:
-
-    void resolve_border_collision_recursive(Simulation& simulation, Grid& grid,
-            Particle& particle, SpatialVector& acceleration,
-            double& remaining_time, int recursion_count=0) const;
-
-    bool try_simulate_remainder(Simulation& simulation, Particle& particle,
-            Grid& grid, SpatialVector& acceleration, double& remaining_time,
-            const SpatialVector& start_pos, const SpatialVector& start_vel) const;
-
-    std::tuple<SpatialVector, SpatialVector> interpolate_to_boundary(
-            Simulation& simulation, Particle& particle,
-            Grid& grid, double& remaining_time, const SpatialVector& start_pos,
-            const SpatialVector& start_vel) const;
-
-    SubdivideResults boundary_collision_subdivide(Simulation& simulation,
-            Particle& particle, Grid& grid, SpatialVector& acceleration,
-            double& remaining_time, const SpatialVector& position,
-            const SpatialVector& velocity) const;
-
-    void resolve_border_collision_recursive2(Simulation& simulation, Grid& grid,
-            Particle& particle, SpatialVector& acceleration,
-            double& remaining_time) const;
-
     PositionType m_bounce_coeff = 1.00;
-    int m_division_levels = 3;
 };
 
 #endif
@@ -0,0 +1,79 @@
+#include "CellNeighborForceSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Grid.h"
+#include "Particle.h"
+
+ForceType CellNeighborForceSolver::compute_force(const Particle& particle, 
+        const SpatialVector& position, const SpatialVector& velocity,
+        const Simulation& simulation, const Grid& grid) const {
+    auto force = AccumulatorVector::zero();
+    auto& interactions = grid.interactions();
+    //Pair overrides can reach further than the particle's own interaction,
+    //so the stencil covers the largest cutoff of any pair it takes part in.
+    auto cutoff = particle.interaction_type() == NO_INTERACTION_TYPE
+        ? particle.interaction().cutoff_radius()
+        : interactions.max_cutoff_radius(particle.interaction_type());
+
+    if(cutoff == std::numeric_limits<PositionType>::infinity()) {
+        for(auto& item : grid) {
+            auto& target = item.particle();
+            if(&target == &particle) continue;
+            force += AccumulatorVector(
+                interactions.interaction_between(particle, target)
+                .compute_force(target, particle, 
+                    grid.nearest_image(position, target.position()), velocity));
+        }
+        return ForceType(force);
+    }
+
+    //Every cell overlapping the square [position - cutoff, position + cutoff].
+    //On a periodic grid the range continues on the opposite side, covering
+    //each cell at most once.
+    auto xres = static_cast<int>(grid.xres());
+    auto yres = static_cast<int>(grid.yres());
+    auto x_begin = static_cast<int>(std::floor((position.x - cutoff) / grid.dx()));
+    auto y_begin = static_cast<int>(std::floor((position.y - cutoff) / grid.dy()));
+    auto x_end = static_cast<int>(std::floor((position.x + cutoff) / grid.dx()));
+    auto y_end = static_cast<int>(std::floor((position.y + cutoff) / grid.dy()));
+    if(grid.is_periodic()) {
+        if(x_end - x_begin >= xres) {
+            x_begin = 0;
+            x_end = xres - 1;
+        }
+        if(y_end - y_begin >= yres) {
+            y_begin = 0;
+            y_end = yres - 1;
+        }
+    } else {
+        x_begin = std::max(0, x_begin);
+        y_begin = std::max(0, y_begin);
+        x_end = std::min(xres - 1, x_end);
+        y_end = std::min(yres - 1, y_end);
+    }
+    auto wrap_index = [](int index, int res) {
+        return ((index % res) + res) % res;
+    };
+
+    auto cutoff_squared = cutoff * cutoff;
+
+    for(int y = y_begin; y <= y_end; ++y) {
+        for(int x = x_begin; x <= x_end; ++x) {
+            for(auto& item : grid.cell(wrap_index(x, xres), wrap_index(y, yres))) {
+                auto& target = item.particle();
+                if(&target == &particle) continue;
+                auto image = grid.nearest_image(position, target.position());
+                if((target.position() - image).magnitude_squared() 
+                        > cutoff_squared) continue;
+                force += AccumulatorVector(
+                    interactions.interaction_between(particle, target)
+                    .compute_force(target, particle, image, velocity));
+            }
+        }
+    }
+
+    return ForceType(force);
+}
@@ -0,0 +1,28 @@
+#ifndef CELLNEIGHBORFORCESOLVER_H_
+#define CELLNEIGHBORFORCESOLVER_H_
+
+#include "IForceSolver.h"
+
+//Force solver for short range interactions. Only particles in the Grid cells
+//overlapping the cutoff radius of the particle's interaction are visited, so
+//a frame costs O(N * neighbors). Interactions without a cutoff fall back to
+//visiting every particle.
+class CellNeighborForceSolver: public IForceSolver {
+public:
+    CellNeighborForceSolver() = default;
+    virtual ~CellNeighborForceSolver() = default;
+
+    CellNeighborForceSolver(const CellNeighborForceSolver& other) = delete;
+    CellNeighborForceSolver(CellNeighborForceSolver&& other) noexcept = default;
+    CellNeighborForceSolver& operator =(const CellNeighborForceSolver& other) = delete;
+    CellNeighborForceSolver& operator =(CellNeighborForceSolver&& other) noexcept = default;
+
+    virtual void prepare_frame(const Simulation& simulation, 
+            const Grid& grid) override {}
+
+    virtual ForceType compute_force(const Particle& particle, 
+            const SpatialVector& position, const SpatialVector& velocity,
+            const Simulation& simulation, const Grid& grid) const override;
+};
+
+#endif
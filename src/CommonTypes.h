@@ -4,11 +4,27 @@
 template<typename T>
 class Vector2;
 
+//Particle state is stored as StorageType. Sums over many particles, such as
+//force totals and aggregates, are carried out in AccumulationType.
+#if defined(PRECISION_DOUBLE)
+using StorageType = double;
+using AccumulationType = double;
+#elif defined(PRECISION_MIXED)
+using StorageType = float;
+using AccumulationType = double;
+#else
+using StorageType = float;
+using AccumulationType = float;
+#endif
+
 using ChargeIndexType = int;
-using PositionType = float;
-using QuantityType = float;
-using ChargeType = float;
+using InteractionTypeId = int;
+constexpr InteractionTypeId NO_INTERACTION_TYPE = -1;
+using PositionType = StorageType;
+using QuantityType = StorageType;
+using ChargeType = StorageType;
 using SpatialVector = Vector2<PositionType>;
 using ForceType = SpatialVector;
+using AccumulatorVector = Vector2<AccumulationType>;
 
 #endif
@@ -0,0 +1,23 @@
+#include "ExactForceSolver.h"
+
+#include "Grid.h"
+#include "Particle.h"
+
+ForceType ExactForceSolver::compute_force(const Particle& particle, 
+        const SpatialVector& position, const SpatialVector& velocity,
+        const Simulation& simulation, const Grid& grid) const {
+    auto force = AccumulatorVector::zero();
+
+    auto& interactions = grid.interactions();
+
+    for(auto& item : grid) {
+        auto& target = item.particle();
+        if(&target == &particle) continue;
+        force += AccumulatorVector(
+            interactions.interaction_between(particle, target)
+            .compute_force(target, particle, 
+                grid.nearest_image(position, target.position()), velocity));
+    } 
+
+    return ForceType(force);
+}
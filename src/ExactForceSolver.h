@@ -0,0 +1,24 @@
+#ifndef EXACTFORCESOLVER_H_
+#define EXACTFORCESOLVER_H_
+
+#include "IForceSolver.h"
+
+class ExactForceSolver: public IForceSolver {
+public:
+    ExactForceSolver() = default;
+    virtual ~ExactForceSolver() = default;
+
+    ExactForceSolver(const ExactForceSolver& other) = delete;
+    ExactForceSolver(ExactForceSolver&& other) noexcept = default;
+    ExactForceSolver& operator =(const ExactForceSolver& other) = delete;
+    ExactForceSolver& operator =(ExactForceSolver&& other) noexcept = default;
+
+    virtual void prepare_frame(const Simulation& simulation, 
+            const Grid& grid) override {}
+
+    virtual ForceType compute_force(const Particle& particle, 
+            const SpatialVector& position, const SpatialVector& velocity,
+            const Simulation& simulation, const Grid& grid) const override;
+};
+
+#endif
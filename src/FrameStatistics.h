@@ -0,0 +1,22 @@
+#ifndef PS_FRAME_STATISTICS_H_
+#define PS_FRAME_STATISTICS_H_
+
+#include <cstddef>
+
+//Summary of one simulated frame, gathered only for frames that are reported
+//to an IFrameStatisticsSink.
+struct FrameStatistics {
+    std::size_t frame_index = 0;
+    double simulation_time = 0.0;
+    double time_step = 0.0;
+    //Seconds spent in do_frame.
+    double wall_time = 0.0;
+    std::size_t particle_count = 0;
+    //Calls to the force solver, which may be more than one per particle
+    //with batch integrators or block time steps.
+    std::size_t force_evaluations = 0;
+    std::size_t wall_collisions = 0;
+    std::size_t particle_collisions = 0;
+};
+
+#endif
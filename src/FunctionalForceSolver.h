@@ -0,0 +1,122 @@
+#ifndef FUNCTIONALFORCESOLVER_H_
+#define FUNCTIONALFORCESOLVER_H_
+
+#include <vector>
+
+#include "IForceSolver.h"
+#include "FunctionalParticleInteraction.h"
+#include "Grid.h"
+#include "InteractionRegistry.h"
+
+//All pairs solver for populations built from FunctionalParticleInteraction<Fn>.
+//Pairs whose interaction has that exact type call the force function without
+//virtual dispatch, so it can be inlined into the loop. Any other pair goes
+//through the regular virtual interface.
+template<typename Fn>
+class FunctionalForceSolver: public IForceSolver {
+public:
+    using Interaction = FunctionalParticleInteraction<Fn>;
+
+    FunctionalForceSolver() = default;
+    virtual ~FunctionalForceSolver() = default;
+
+    FunctionalForceSolver(const FunctionalForceSolver& other) = delete;
+    FunctionalForceSolver(FunctionalForceSolver&& other) noexcept = default;
+    FunctionalForceSolver& operator =(const FunctionalForceSolver& other) = delete;
+    FunctionalForceSolver& operator =(FunctionalForceSolver&& other) noexcept = default;
+
+    virtual void prepare_frame(const Simulation& simulation,
+            const Grid& grid) override;
+
+    virtual ForceType compute_force(const Particle& particle,
+            const SpatialVector& position, const SpatialVector& velocity,
+            const Simulation& simulation, const Grid& grid) const override;
+
+    //Set when every particle shares one type whose interaction is an
+    //Interaction, in which case the whole loop is devirtualized.
+    const Interaction* uniform_interaction() const {return m_uniform;}
+
+private:
+    static ForceType evaluate(const Interaction& interaction,
+            const Particle& target, const Particle& src,
+            const SpatialVector& position, const SpatialVector& velocity) {
+        //Qualified call, resolved statically.
+        return interaction.Interaction::compute_force(target, src,
+                position, velocity);
+    }
+
+    //Row major by source type, null where the pair is not an Interaction.
+    std::vector<const Interaction*> m_pair_table;
+    std::size_t m_num_types = 0;
+    const Interaction* m_uniform = nullptr;
+};
+
+template<typename Fn>
+inline void FunctionalForceSolver<Fn>::prepare_frame(const Simulation& simulation,
+        const Grid& grid) {
+    auto& interactions = grid.interactions();
+    m_num_types = interactions.num_types();
+    m_pair_table.assign(m_num_types * m_num_types, nullptr);
+    for(std::size_t src = 0; src < m_num_types; ++src) {
+        for(std::size_t target = 0; target < m_num_types; ++target) {
+            m_pair_table[src*m_num_types + target] = dynamic_cast<const Interaction*>(
+                    &interactions.pair_interaction(src, target));
+        }
+    }
+
+    m_uniform = nullptr;
+    auto type = NO_INTERACTION_TYPE;
+    for(auto& item : grid) {
+        auto item_type = item.particle().interaction_type();
+        if(item_type == NO_INTERACTION_TYPE
+                || (type != NO_INTERACTION_TYPE && item_type != type)) {
+            return;
+        }
+        type = item_type;
+    }
+    if(type != NO_INTERACTION_TYPE) {
+        m_uniform = m_pair_table[type*m_num_types + type];
+    }
+}
+
+template<typename Fn>
+inline ForceType FunctionalForceSolver<Fn>::compute_force(const Particle& particle,
+        const SpatialVector& position, const SpatialVector& velocity,
+        const Simulation& simulation, const Grid& grid) const {
+    auto force = AccumulatorVector::zero();
+
+    if(m_uniform != nullptr) {
+        for(auto& item : grid) {
+            auto& target = item.particle();
+            if(&target == &particle) continue;
+            force += AccumulatorVector(evaluate(*m_uniform, target, particle,
+                    grid.nearest_image(position, target.position()), velocity));
+        }
+        return ForceType(force);
+    }
+
+    auto& interactions = grid.interactions();
+    auto src_type = particle.interaction_type();
+
+    for(auto& item : grid) {
+        auto& target = item.particle();
+        if(&target == &particle) continue;
+        auto target_type = target.interaction_type();
+        auto image = grid.nearest_image(position, target.position());
+        if(src_type != NO_INTERACTION_TYPE && target_type != NO_INTERACTION_TYPE) {
+            auto interaction = m_pair_table[src_type*m_num_types + target_type];
+            if(interaction != nullptr) {
+                force += AccumulatorVector(evaluate(*interaction, target, particle,
+                        image, velocity));
+                continue;
+            }
+        }
+        force += AccumulatorVector(
+            interactions.interaction_between(particle, target)
+            .compute_force(target, particle, image, velocity));
+    }
+
+    return ForceType(force);
+}
+
+#endif
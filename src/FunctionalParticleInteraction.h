@@ -3,6 +3,7 @@
 
 #include <utility>
 #include <vector>
+#include <limits>
 
 #include "ParticleInteraction.h"
 #include "Vector2.h"
@@ -39,6 +40,15 @@ public:
         m_charge_indices = std::move(charge_indices);
     }
 
+    virtual PositionType cutoff_radius() const override {
+        return m_cutoff_radius;
+    }
+    FunctionalParticleInteraction& set_cutoff_radius(PositionType value) {
+        m_cutoff_radius = value;
+        m_cutoff_squared = value * value;
+        return *this;
+    }
+
     virtual std::unique_ptr<ClonableParticleInteraction> clone() const override {
         return std::unique_ptr<ClonableParticleInteraction>(
             new FunctionalParticleInteraction<Fn>(*this));
@@ -47,6 +57,8 @@ public:
 private:
     Fn m_fn;
     std::vector<ChargeIndexType> m_charge_indices;
+    PositionType m_cutoff_radius = std::numeric_limits<PositionType>::infinity();
+    PositionType m_cutoff_squared = std::numeric_limits<PositionType>::infinity();
 };
 
 template <typename Fn>
@@ -85,13 +97,16 @@ inline FunctionalParticleInteraction<Fn>::FunctionalParticleInteraction(
 template <typename Fn>
 inline ForceType FunctionalParticleInteraction<Fn>::compute_force(
         const Particle& target, const Particle& src) const {
-    return m_fn(target, src, src.next_position(), src.next_velocity()); 
+    return compute_force(target, src, src.next_position(), src.next_velocity()); 
 }
  
 template<typename Fn>
 inline ForceType FunctionalParticleInteraction<Fn>::compute_force(const Particle& target, 
         const Particle& src, const SpatialVector& position, 
         const SpatialVector& velocity) const {
+    if((target.position() - position).magnitude_squared() > m_cutoff_squared) {
+        return ForceType::zero();
+    }
     return m_fn(target, src, position, velocity); 
 }
  
@@ -1,8 +1,33 @@
 #include "Grid.h"
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <cassert>
 
+#include "SimulationSnapshot.h"
+#include "WorkerPool.h"
+
+namespace {
+
+//Spreads the low 16 bits of value over the even bits of the result.
+std::uint32_t spread_bits(std::uint32_t value) {
+    value &= 0x0000ffff;
+    value = (value | (value << 8)) & 0x00ff00ff;
+    value = (value | (value << 4)) & 0x0f0f0f0f;
+    value = (value | (value << 2)) & 0x33333333;
+    value = (value | (value << 1)) & 0x55555555;
+    return value;
+}
+
+std::uint32_t quantize(PositionType value, PositionType extent) {
+    constexpr PositionType STEPS = 65536;
+    auto step = static_cast<long>(value / extent * STEPS);
+    return static_cast<std::uint32_t>(std::min(std::max(step, 0L), 65535L));
+}
+
+}
+
 /*GridParticle::GridParticle(const Particle& particle):
     m_particle(particle)
 {}*/
@@ -19,40 +44,51 @@ Grid::Grid(PositionType width, PositionType height, int xres, int yres):
     build_grid(); 
 }
  
-/*Grid::iterator Grid::insert(const Particle& particle) {
-    return insert(std::make_unique<GridParticle>(particle));
-}*/
-
-Grid::iterator Grid::insert(Particle&& particle) {
-    return insert(std::make_unique<GridParticle>(std::move(particle)));
+GridParticle& Grid::insert(Particle&& particle) {
+    auto id = particle.id();
+    assert(!contains(id));
+    //The store keeps its entries in the order of m_particles.
+    particle.move_to(*m_store);
+    auto handle = m_particles.insert(GridParticle(std::move(particle)));
+    m_handle_of_id[id] = handle;
+    return m_particles[handle];
 }
-
-Grid::iterator Grid::insert(std::unique_ptr<GridParticle> p) {
-    auto idx = position_to_cell(p->particle().position());  
-    auto& cell = m_cells[idx];
-    auto id = p->particle().id();
-    auto it = m_particles.insert(std::make_pair(id, std::move(p)));
-    assert(it.second);
-    auto& item = it.first;
-    cell.insert(item->second.get());
-    return it.first;
-}
- 
-/*void Grid::add(const Particle& particle) {
-    m_insertList.emplace_back(std::make_unique<GridParticle>(particle)); 
-}*/
  
 void Grid::add(Particle&& particle) {
-    m_insertList.emplace_back(std::make_unique<GridParticle>(std::move(particle))); 
+    m_insertList.emplace_back(std::move(particle)); 
+}
+ 
+void Grid::remove(int id) {
+    m_deleteList.push_back(id);
 }
  
 void Grid::next_frame() {
-    apply_insert_list();
-    apply_delete_list();
-    for(auto& item : m_particles) {
-        auto& p = item.second;
-        p->particle().apply_update();
+    auto relink = false;
+    if(!m_insertList.empty() || !m_deleteList.empty()) {
+        apply_insert_list();
+        apply_delete_list();
+        relink = true;
     }
+    if(m_spatial_sort_interval > 0 
+            && ++m_frames_since_sort >= m_spatial_sort_interval) {
+        m_frames_since_sort = 0;
+        sort_particles();
+        relink = true;
+    }
+    if(relink) {
+        rebuild_cells();
+    }
+    m_store->apply_update();
+}
+ 
+SpatialVector Grid::wrap(const SpatialVector& pos) const {
+    auto wrap_coordinate = [](PositionType value, PositionType period) {
+        value -= period * std::floor(value / period);
+        //Rounding can land a tiny negative value exactly on the period.
+        return value < period ? value : PositionType(0);
+    };
+    return SpatialVector(wrap_coordinate(pos.x, m_width), 
+            wrap_coordinate(pos.y, m_height));
 }
  
 void Grid::update_particle(GridParticle& particle) {
@@ -64,6 +100,118 @@ void Grid::update_particle(GridParticle& particle) {
     }
 }
  
+void Grid::sort_particles() {
+    auto count = m_particles.size();
+    m_sort_keys.resize(count);
+    m_sort_order.resize(count);
+    for(std::size_t i = 0; i < count; ++i) {
+        auto position = m_particles.value_at(i).next_position();
+        m_sort_keys[i] = spread_bits(quantize(position.x, m_width)) 
+            | (spread_bits(quantize(position.y, m_height)) << 1);
+        m_sort_order[i] = i;
+    }
+
+    //Particles move little between sorts, so the current order is nearly
+    //sorted and insertion sort runs in close to linear time. A full sort
+    //takes over when it is not, such as on the first sort.
+    auto by_key = [this](std::size_t lhs, std::size_t rhs) {
+        return m_sort_keys[lhs] < m_sort_keys[rhs];
+    };
+    std::size_t moves = 0;
+    auto move_budget = 8 * count;
+    for(std::size_t i = 1; i < count && moves <= move_budget; ++i) {
+        auto index = m_sort_order[i];
+        auto j = i;
+        for(; j > 0 && by_key(index, m_sort_order[j-1]); --j) {
+            m_sort_order[j] = m_sort_order[j-1];
+            ++moves;
+        }
+        m_sort_order[j] = index;
+    }
+    if(moves > move_budget) {
+        std::stable_sort(m_sort_order.begin(), m_sort_order.end(), by_key);
+    }
+
+    if(moves > 0) {
+        m_particles.reorder(m_sort_order);
+        m_store->reorder(m_sort_order);
+        for(std::size_t i = 0; i < count; ++i) {
+            m_particles.value_at(i).particle().set_store_index(i);
+        }
+    }
+}
+ 
+void Grid::update_cells(WorkerPool* pool) {
+    if(pool == nullptr || pool->num_workers() <= 1) {
+        for(auto& item : m_particles) {
+            update_particle(item);
+        }
+        return;
+    }
+
+    auto count = m_particles.size();
+    auto num_cells = m_cells.size();
+    auto num_slices = pool->num_workers();
+    auto slice_size = (count + num_slices - 1) / num_slices;
+    auto for_each_in_slices = [&](const std::function<void (std::size_t, 
+            std::size_t)>& fn) {
+        pool->parallel_for(num_slices, 
+            [&](std::size_t begin, std::size_t end, std::size_t) {
+                for(auto slice = begin; slice < end; ++slice) {
+                    auto last = std::min(count, (slice + 1) * slice_size);
+                    for(auto i = slice * slice_size; i < last; ++i) {
+                        fn(slice, i);
+                    }
+                }
+            });
+    };
+
+    m_cell_of.resize(count);
+    m_cell_order.resize(count);
+    m_cell_begin.resize(num_cells + 1);
+    m_slice_offsets.assign(num_slices * num_cells, 0);
+
+    //New cell of every particle, counted per slice.
+    for_each_in_slices([this, num_cells](std::size_t slice, std::size_t i) {
+        auto cell_idx = position_to_cell(m_particles.value_at(i).next_position());
+        m_cell_of[i] = cell_idx;
+        m_slice_offsets[slice * num_cells + cell_idx] += 1;
+    });
+
+    //Each cell gets a contiguous range of m_cell_order, split between the
+    //slices in order, which keeps the result independent of scheduling.
+    std::size_t total = 0;
+    for(std::size_t cell_idx = 0; cell_idx < num_cells; ++cell_idx) {
+        m_cell_begin[cell_idx] = total;
+        for(std::size_t slice = 0; slice < num_slices; ++slice) {
+            auto& offset = m_slice_offsets[slice * num_cells + cell_idx];
+            auto slice_count = offset;
+            offset = total;
+            total += slice_count;
+        }
+    }
+    m_cell_begin[num_cells] = total;
+
+    for_each_in_slices([this, num_cells](std::size_t slice, std::size_t i) {
+        auto& offset = m_slice_offsets[slice * num_cells + m_cell_of[i]];
+        m_cell_order[offset++] = i;
+    });
+
+    //Every particle is linked into exactly one cell, so cells can be
+    //relinked concurrently.
+    pool->parallel_for(num_cells, 
+        [this](std::size_t begin, std::size_t end, std::size_t) {
+            for(auto cell_idx = begin; cell_idx < end; ++cell_idx) {
+                auto& cell = m_cells[cell_idx];
+                auto last = m_cell_begin[cell_idx + 1];
+                cell.clear();
+                for(auto k = m_cell_begin[cell_idx]; k < last; ++k) {
+                    cell.insert(&m_particles.value_at(m_cell_order[k]));
+                }
+            }
+        });
+}
+ 
 std::ostream& Grid::print_particle_density(std::ostream& stream, int level) const {
     for(int y = 0; y < m_yres; ++y) {
         for(int x = 0; x < m_xres; ++x) {
@@ -74,9 +222,167 @@ std::ostream& Grid::print_particle_density(std::ostream& stream, int level) cons
     return stream;
 }
  
-void Grid::remove_from_grid(GridParticle& item) {
-    item.containing_cell()->remove(&item);
-    m_particles.erase(item.id()); 
+bool Grid::write_snapshot(SnapshotWriter& writer) const {
+    for(auto& item : m_particles) {
+        if(item.particle().interaction_type() == NO_INTERACTION_TYPE) {
+            return false;
+        }
+    }
+    for(auto& particle : m_insertList) {
+        if(particle.interaction_type() == NO_INTERACTION_TYPE) {
+            return false;
+        }
+    }
+
+    writer.write(m_width);
+    writer.write(m_height);
+    writer.write(m_xres);
+    writer.write(m_yres);
+    writer.write(static_cast<std::uint8_t>(m_periodic));
+    writer.write(m_spatial_sort_interval);
+    writer.write(m_frames_since_sort);
+
+    writer.write(static_cast<std::uint64_t>(m_particles.size()));
+    for(auto& item : m_particles) {
+        item.particle().write_snapshot(writer);
+    }
+    for(auto& cell : m_cells) {
+        writer.write(static_cast<std::uint32_t>(cell.size()));
+        for(auto& item : cell) {
+            writer.write(static_cast<std::uint32_t>(
+                        &item - &m_particles.value_at(0)));
+        }
+    }
+
+    writer.write(static_cast<std::uint64_t>(m_insertList.size()));
+    for(auto& particle : m_insertList) {
+        particle.write_snapshot(writer);
+    }
+    writer.write(static_cast<std::uint64_t>(m_deleteList.size()));
+    for(auto id : m_deleteList) {
+        writer.write(id);
+    }
+    return true;
+}
+ 
+bool Grid::read_snapshot(SnapshotReader& reader) {
+    auto width = reader.read<PositionType>();
+    auto height = reader.read<PositionType>();
+    auto xres = reader.read<int>();
+    auto yres = reader.read<int>();
+    if(!reader.ok() || width != m_width || height != m_height 
+            || xres != m_xres || yres != m_yres) {
+        return false;
+    }
+    auto periodic = reader.read<std::uint8_t>() != 0;
+    auto spatial_sort_interval = reader.read<int>();
+    auto frames_since_sort = reader.read<int>();
+
+    auto read_particles = [this, &reader](std::vector<Particle>& particles) {
+        //Every particle takes at least its id.
+        auto count = reader.read<std::uint64_t>();
+        if(!reader.expect(count, sizeof(int))) {
+            return;
+        }
+        particles.reserve(count);
+        for(std::uint64_t i = 0; i < count && reader.ok(); ++i) {
+            auto particle = Particle::read_snapshot(reader);
+            auto type = particle.interaction_type();
+            if(particle.id() < 0 || type < 0 
+                    || static_cast<std::size_t>(type) >= m_interactions->num_types()) {
+                reader.fail();
+                return;
+            }
+            particle.set_interaction(type, m_interactions->interaction(type));
+            particles.push_back(std::move(particle));
+        }
+    };
+
+    std::vector<Particle> particles;
+    read_particles(particles);
+    std::vector<std::uint32_t> cell_sizes(m_cells.size());
+    std::vector<std::uint32_t> cell_order;
+    cell_order.reserve(particles.size());
+    for(auto& size : cell_sizes) {
+        size = reader.read<std::uint32_t>();
+        if(!reader.expect(size, sizeof(std::uint32_t))) {
+            break;
+        }
+        for(std::uint32_t i = 0; i < size; ++i) {
+            cell_order.push_back(reader.read<std::uint32_t>());
+        }
+    }
+
+    //Every particle needs a unique id and exactly one cell.
+    std::vector<bool> seen;
+    for(auto& particle : particles) {
+        if(!reader.ok()) break;
+        auto id = static_cast<std::size_t>(particle.id());
+        seen.resize(std::max(seen.size(), id + 1));
+        if(seen[id]) {
+            reader.fail();
+        }
+        seen[id] = true;
+    }
+    seen.assign(particles.size(), false);
+    for(auto index : cell_order) {
+        if(index >= particles.size() || seen[index]) {
+            reader.fail();
+            break;
+        }
+        seen[index] = true;
+    }
+    if(cell_order.size() != particles.size()) {
+        reader.fail();
+    }
+
+    std::vector<Particle> insert_list;
+    read_particles(insert_list);
+    std::vector<int> delete_list;
+    auto num_deleted = reader.read<std::uint64_t>();
+    if(reader.expect(num_deleted, sizeof(int))) {
+        for(std::uint64_t i = 0; i < num_deleted; ++i) {
+            delete_list.push_back(reader.read<int>());
+        }
+    }
+    if(!reader.ok()) {
+        return false;
+    }
+
+    //Everything was read, so the grid can be replaced.
+    for(auto& cell : m_cells) {
+        cell.clear();
+    }
+    m_particles.clear();
+    m_store->clear();
+    m_handle_of_id.clear();
+    for(auto& particle : particles) {
+        insert(std::move(particle));
+    }
+    auto next = cell_order.begin();
+    for(std::size_t cell_idx = 0; cell_idx < m_cells.size(); ++cell_idx) {
+        for(std::uint32_t i = 0; i < cell_sizes[cell_idx]; ++i, ++next) {
+            m_cells[cell_idx].insert(&m_particles.value_at(*next));
+        }
+    }
+
+    m_insertList = std::move(insert_list);
+    m_deleteList = std::move(delete_list);
+    m_periodic = periodic;
+    m_spatial_sort_interval = spatial_sort_interval;
+    m_frames_since_sort = frames_since_sort;
+    return true;
+}
+ 
+void Grid::remove_from_grid(int id) {
+    assert(contains(id));
+    auto it = m_handle_of_id.find(id);
+    //Erasing moves the last particle into the hole, and moving a particle
+    //onto one in the grid copies its state into that entry, so only the
+    //last entry has to go.
+    m_particles.erase(it->second);
+    m_store->pop_back();
+    m_handle_of_id.erase(it);
 }
  
 void Grid::apply_insert_list() {
@@ -87,12 +393,21 @@ void Grid::apply_insert_list() {
 }
  
 void Grid::apply_delete_list() {
-    for(auto& particle : m_deleteList) {
-        remove_from_grid(*particle);
+    for(auto id : m_deleteList) {
+        remove_from_grid(id);
     } 
     m_deleteList.clear();
 }
  
+void Grid::rebuild_cells() {
+    for(auto& cell : m_cells) {
+        cell.clear();
+    }
+    for(auto& item : m_particles) {
+        m_cells[position_to_cell(item.position())].insert(&item);
+    }
+}
+ 
 void Grid::build_grid() {
     m_cells.reserve(m_xres*m_yres); 
     for(int y = 0; y < m_yres; ++y) {
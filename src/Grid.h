@@ -2,17 +2,23 @@
 #define PS_GRID_H_
 
 #include <cassert>
+#include <cmath>
 #include <vector>
-#include <unordered_map>
 #include <memory>
 #include <list>
+#include <unordered_map>
 
 #include "CommonTypes.h"
 #include "Vector2.h"
 #include "Particle.h"
 #include "IntrusiveList.h"
+#include "SlotMap.h"
+#include "InteractionRegistry.h"
 
 class GridParticle;
+class WorkerPool;
+class SnapshotWriter;
+class SnapshotReader;
 
 class GridCell {
 public:
@@ -45,6 +51,11 @@ public:
 
     int grid_index() const {return m_idx;}
 
+    //Drops every particle from the cell without touching their links.
+    void clear() {
+        m_particles.clear();
+    }
+
 private:
     ParticleContainer m_particles;
 
@@ -100,7 +111,8 @@ private:
 
 class Grid {
 public:
-    using ParticleContainer = std::unordered_map<int, std::unique_ptr<GridParticle>>;
+    using ParticleContainer = SlotMap<GridParticle>;
+    using ParticleHandle = ParticleContainer::Handle;
     using iterator = ParticleContainer::iterator;
     using const_iterator = ParticleContainer::const_iterator;
 
@@ -130,6 +142,18 @@ public:
     std::size_t num_cells() const {return m_cells.size();}
 
     void add(Particle&& particle);
+    void remove(int id);
+
+    bool contains(int id) const {
+        auto it = m_handle_of_id.find(id);
+        return it != m_handle_of_id.end() && m_particles.contains(it->second);
+    }
+    //Position of the particle in iteration order, which changes when
+    //particles are inserted, removed or sorted.
+    std::size_t index_of(int id) const {
+        assert(contains(id));
+        return m_particles.index_of(m_handle_of_id.find(id)->second);
+    }
 
     constexpr std::size_t position_to_cell(const SpatialVector& pos) const {
         auto x = static_cast<int>(pos.x * m_1_over_dx); 
@@ -159,6 +183,32 @@ public:
         return (pos.x >= 0 && pos.y >= 0 && pos.x < m_width && pos.y < m_height);
     }
 
+    //A periodic grid wraps around at its edges. Positions leaving it are
+    //wrapped back in, and distances are taken to the nearest periodic image.
+    bool is_periodic() const {return m_periodic;}
+    void set_periodic(bool value) {m_periodic = value;}
+
+    //Brings a position of a periodic grid back into the grid.
+    SpatialVector wrap(const SpatialVector& pos) const;
+
+    //Copy of position moved by whole grid periods to lie as close as
+    //possible to reference. Unchanged unless the grid is periodic.
+    SpatialVector nearest_image(const SpatialVector& position, 
+            const SpatialVector& reference) const {
+        if(!m_periodic) {
+            return position;
+        }
+        auto delta = position - reference;
+        delta.x -= m_width * std::round(delta.x / m_width);
+        delta.y -= m_height * std::round(delta.y / m_height);
+        return reference + delta;
+    }
+    //Shortest vector from one position to another.
+    SpatialVector displacement(const SpatialVector& from, 
+            const SpatialVector& to) const {
+        return nearest_image(to, from) - from;
+    }
+
     GridCell& cell(std::size_t x, std::size_t y) {
         assert(x+y*m_xres < m_cells.size());
         return m_cells[x + y*m_xres];
@@ -167,35 +217,99 @@ public:
         assert(idx < m_cells.size());
         return m_cells[idx]; 
     }
+    const GridCell& cell(std::size_t x, std::size_t y) const {
+        assert(x+y*m_xres < m_cells.size());
+        return m_cells[x + y*m_xres];
+    }
+    const GridCell& cell(std::size_t idx) const {
+        assert(idx < m_cells.size());
+        return m_cells[idx]; 
+    }
 
     Particle& get_particle_by_id(int id) {
-        return m_particles.at(id)->particle();
+        assert(contains(id));
+        return m_particles[m_handle_of_id.find(id)->second].particle();
     }
     const Particle& get_particle_by_id(int id) const {
-        return m_particles.at(id)->particle();
+        assert(contains(id));
+        return m_particles[m_handle_of_id.find(id)->second].particle();
     }
 
     void next_frame();
     void update_particle(GridParticle& particle);
+    //Moves every particle into the cell of its next position. Given a pool
+    //with several workers, the cells are rebuilt in parallel from a counting
+    //sort of the new cell indices instead of splicing particles one by one.
+    void update_cells(WorkerPool* pool = nullptr);
+
+    //Every interval-th call to next_frame reorders the particles along a
+    //Morton curve of their positions, so that particles close in space are
+    //close in memory and in iteration order. 0 disables the sorting.
+    void set_spatial_sort_interval(int frames) {
+        m_spatial_sort_interval = frames;
+        m_frames_since_sort = 0;
+    }
+    int spatial_sort_interval() const {return m_spatial_sort_interval;}
+
+    //Physical state of the particles, entry i belonging to the i-th
+    //particle in iteration order.
+    ParticleStore& particle_store() {return *m_store;}
+    const ParticleStore& particle_store() const {return *m_store;}
+
+    //Shared interaction objects referenced by the particles in this grid.
+    InteractionRegistry& interactions() {return *m_interactions;}
+    const InteractionRegistry& interactions() const {return *m_interactions;}
 
     std::ostream& print_particle_density(std::ostream& stream, int level=0) const;
 
+    //Particles, including pending insertions and removals, and the order of
+    //the cell lists, which decides the order forces are summed in. Writing
+    //fails if a particle has no registered interaction type. Reading only
+    //changes the grid if it succeeds, and needs a grid of the same shape
+    //whose registry holds the types the particles refer to.
+    bool write_snapshot(SnapshotWriter& writer) const;
+    bool read_snapshot(SnapshotReader& reader);
+
 private:
-    iterator insert(const Particle& m_particle);
-    iterator insert(Particle&& particle);
-    iterator insert(std::unique_ptr<GridParticle> m_particle);
-    void remove_from_grid(GridParticle& m_particle);
+    GridParticle& insert(Particle&& particle);
+    void remove_from_grid(int id);
     void update_forces();
 
     void apply_insert_list();
     void apply_delete_list();
+    //Inserting or removing can move particles within m_particles, so the
+    //cell lists are relinked from scratch afterwards.
+    void rebuild_cells();
+    //Reorders m_particles by the Morton key of the next positions. Cells
+    //must be rebuilt afterwards.
+    void sort_particles();
+
+    //Declared first so they outlive the particles referring to them. Held by
+    //pointer so their addresses survive moving the grid.
+    std::unique_ptr<ParticleStore> m_store = std::make_unique<ParticleStore>();
+    std::unique_ptr<InteractionRegistry> m_interactions = 
+        std::make_unique<InteractionRegistry>();
 
     std::vector<GridCell> m_cells;
 
-    std::unordered_map<int, std::unique_ptr<GridParticle>> m_particles;
+    ParticleContainer m_particles;
+    //Only holds the particles currently in the grid, since ids are never
+    //reused and keep growing.
+    std::unordered_map<int, ParticleHandle> m_handle_of_id;
+
+    std::vector<int> m_deleteList;
+    std::vector<Particle> m_insertList;
+
+    //Scratch space of update_cells, kept between frames.
+    std::vector<std::size_t> m_cell_of;
+    std::vector<std::size_t> m_cell_order;
+    std::vector<std::size_t> m_cell_begin;
+    std::vector<std::size_t> m_slice_offsets;
 
-    std::vector<GridParticle*> m_deleteList;
-    std::vector<std::unique_ptr<GridParticle>> m_insertList;
+    int m_spatial_sort_interval = 0;
+    int m_frames_since_sort = 0;
+    std::vector<std::uint32_t> m_sort_keys;
+    std::vector<std::size_t> m_sort_order;
 
     void build_grid();
 
@@ -207,6 +321,7 @@ private:
     PositionType m_dy;
     PositionType m_1_over_dx;
     PositionType m_1_over_dy;
+    bool m_periodic = false;
 };
 
 #endif
@@ -0,0 +1,35 @@
+#ifndef IBATCHMOTIONINTEGRATOR_H_
+#define IBATCHMOTIONINTEGRATOR_H_
+
+#include "IMotionIntegrator.h"
+
+//Integrator split into phases that the simulation runs over every particle
+//in turn: drift moves all particles using their start of step acceleration,
+//then the forces are evaluated once against the drifted positions, then
+//kick finishes the velocities with the end of step acceleration.
+class IBatchMotionIntegrator: public IMotionIntegrator {
+public:
+    IBatchMotionIntegrator() = default;
+    virtual ~IBatchMotionIntegrator() = default;
+
+    virtual void drift(Particle& particle, double dt, 
+            const SpatialVector& acceleration, SpatialVector& position, 
+            SpatialVector& velocity) const = 0;
+
+    virtual void kick(Particle& particle, double dt, 
+            const SpatialVector& end_acceleration, 
+            SpatialVector& velocity) const = 0;
+
+    //Used for the partial steps of the boundary resolver, where no end of
+    //step forces are available. Holds the acceleration constant over dt.
+    virtual void advance_motion(Simulation& simulation, Particle& particle, 
+            double dt, const SpatialVector& acceleration, SpatialVector& position,
+            SpatialVector& velocity) const override {
+        drift(particle, dt, acceleration, position, velocity);
+        kick(particle, dt, acceleration, velocity);
+    }
+
+private:
+};
+
+#endif
@@ -15,6 +15,14 @@ public:
 
     virtual void resolve_border_collision(Simulation& simulation, Grid& grid,
             Particle& particle, SpatialVector& acceleration) const = 0;
+
+    //Fixes up the end of a step that left the grid without running it again.
+    //Resolvers that need the full step return false, and the step is then
+    //discarded and handed to resolve_border_collision.
+    virtual bool resolve_step_end(const Grid& grid, const Particle& particle,
+            SpatialVector& position, SpatialVector& velocity) const {
+        return false;
+    }
 };
 
 #endif
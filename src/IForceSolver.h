@@ -0,0 +1,27 @@
+#ifndef IFORCESOLVER_H_
+#define IFORCESOLVER_H_
+
+#include "Vector2.h"
+#include "CommonTypes.h"
+
+class Particle;
+class Simulation;
+class Grid;
+
+class IForceSolver {
+public:
+    IForceSolver() = default;
+    virtual ~IForceSolver() = default;
+
+    //Called once per frame, before any forces are requested, so solvers
+    //can rebuild acceleration structures from the current particle positions.
+    virtual void prepare_frame(const Simulation& simulation, const Grid& grid) = 0;
+
+    virtual ForceType compute_force(const Particle& particle, 
+            const SpatialVector& position, const SpatialVector& velocity,
+            const Simulation& simulation, const Grid& grid) const = 0;
+
+private:
+};
+
+#endif
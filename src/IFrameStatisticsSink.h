@@ -0,0 +1,16 @@
+#ifndef IFRAMESTATISTICSSINK_H_
+#define IFRAMESTATISTICSSINK_H_
+
+#include "FrameStatistics.h"
+
+//Receives the statistics of sampled frames at the end of do_frame, on the
+//simulation thread.
+class IFrameStatisticsSink {
+public:
+    IFrameStatisticsSink() = default;
+    virtual ~IFrameStatisticsSink() {};
+
+    virtual void on_frame(const FrameStatistics& statistics) = 0;
+};
+
+#endif
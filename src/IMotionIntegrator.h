@@ -16,6 +16,11 @@ public:
             const SpatialVector& acceleration, SpatialVector& position,
             SpatialVector& velocity) const = 0;
 
+    //True if advance_motion stores the end of step acceleration on the
+    //particle with Particle::cache_next_acceleration, for do_frame to use
+    //in place of the next start of step acceleration.
+    virtual bool caches_end_acceleration() const {return false;}
+
 private:
 };
 
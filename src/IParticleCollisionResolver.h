@@ -0,0 +1,24 @@
+#ifndef IPARTICLECOLLISIONRESOLVER_H_
+#define IPARTICLECOLLISIONRESOLVER_H_
+
+#include <cstddef>
+
+class Simulation;
+class Grid;
+
+//Resolves contacts between particles once every particle has moved, before
+//the frame's updates are applied. Front buffers hold the start of step
+//state and back buffers the end of step state, which a resolver may adjust.
+class IParticleCollisionResolver {
+public:
+    IParticleCollisionResolver() = default;
+    virtual ~IParticleCollisionResolver() {};
+
+    virtual void resolve_particle_collisions(Simulation& simulation, 
+            Grid& grid) = 0;
+
+    //Contacts resolved during the last call.
+    virtual std::size_t collision_count() const {return 0;}
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "InteractionRegistry.h"
+
+#include <algorithm>
+
+InteractionTypeId InteractionRegistry::add_type(
+        std::unique_ptr<IParticleInteraction> interaction) {
+    assert(interaction != nullptr);
+    auto old_count = m_types.size();
+    auto new_count = old_count + 1;
+    m_types.push_back(std::move(interaction));
+
+    //Widen the table, keeping existing entries and filling new pairs with
+    //the source type's own interaction.
+    std::vector<const IParticleInteraction*> table(new_count * new_count);
+    for(std::size_t src = 0; src < new_count; ++src) {
+        for(std::size_t target = 0; target < new_count; ++target) {
+            if(src < old_count && target < old_count) {
+                table[src*new_count + target] = m_pair_table[src*old_count + target];
+            } else {
+                table[src*new_count + target] = m_types[src].get();
+            }
+        }
+    }
+    m_pair_table = std::move(table);
+
+    //Every row gained an entry.
+    m_max_cutoff_radius.resize(new_count);
+    for(std::size_t src = 0; src < new_count; ++src) {
+        update_max_cutoff_radius(static_cast<InteractionTypeId>(src));
+    }
+
+    return static_cast<InteractionTypeId>(old_count);
+}
+ 
+void InteractionRegistry::set_pair_interaction(InteractionTypeId source, 
+        InteractionTypeId target, std::unique_ptr<IParticleInteraction> interaction) {
+    assert(source >= 0 && static_cast<std::size_t>(source) < m_types.size());
+    assert(target >= 0 && static_cast<std::size_t>(target) < m_types.size());
+    assert(interaction != nullptr);
+
+    m_pair_table[source * m_types.size() + target] = interaction.get();
+    m_pair_overrides.push_back(std::move(interaction));
+    update_max_cutoff_radius(source);
+}
+ 
+void InteractionRegistry::update_max_cutoff_radius(InteractionTypeId source) {
+    auto count = m_types.size();
+    auto max = m_types[source]->cutoff_radius();
+    for(std::size_t target = 0; target < count; ++target) {
+        max = std::max(max, m_pair_table[source * count + target]->cutoff_radius());
+    }
+    m_max_cutoff_radius[source] = max;
+}
+ 
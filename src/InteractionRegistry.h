@@ -0,0 +1,75 @@
+#ifndef PS_INTERACTIONREGISTRY_H_
+#define PS_INTERACTIONREGISTRY_H_
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+#include "CommonTypes.h"
+#include "Particle.h"
+#include "ParticleInteraction.h"
+
+//Owns one interaction object per particle type, shared by every particle of
+//that type. Pairs of types default to the source particle's interaction and
+//can be overridden with a dedicated object.
+class InteractionRegistry {
+public:
+    InteractionRegistry() = default;
+    ~InteractionRegistry() = default;
+
+    InteractionRegistry(const InteractionRegistry& other) = delete;
+    InteractionRegistry(InteractionRegistry&& other) noexcept = default;
+    InteractionRegistry& operator =(const InteractionRegistry& other) = delete;
+    InteractionRegistry& operator =(InteractionRegistry&& other) noexcept = default;
+
+    InteractionTypeId add_type(std::unique_ptr<IParticleInteraction> interaction);
+    //Replaces the interaction between particles of two types. Solvers that
+    //approximate far particles by aggregates, which have no type, still use
+    //the source type's own interaction for those terms.
+    void set_pair_interaction(InteractionTypeId source, InteractionTypeId target,
+            std::unique_ptr<IParticleInteraction> interaction);
+
+    std::size_t num_types() const {return m_types.size();}
+
+    const IParticleInteraction& interaction(InteractionTypeId type) const {
+        assert(type >= 0 && static_cast<std::size_t>(type) < m_types.size());
+        return *m_types[type];
+    }
+
+    const IParticleInteraction& pair_interaction(InteractionTypeId source,
+            InteractionTypeId target) const {
+        assert(source >= 0 && static_cast<std::size_t>(source) < m_types.size());
+        assert(target >= 0 && static_cast<std::size_t>(target) < m_types.size());
+        return *m_pair_table[source * m_types.size() + target];
+    }
+
+    //Largest cutoff radius of any interaction a particle of the source type
+    //can be given, including its own for targets without a type. Infinite
+    //if one of them has no cutoff.
+    PositionType max_cutoff_radius(InteractionTypeId source) const {
+        assert(source >= 0 && static_cast<std::size_t>(source) < m_types.size());
+        return m_max_cutoff_radius[source];
+    }
+
+    //Interaction used for the force src exerts on target. Particles that were
+    //not given a registered type use their own interaction.
+    const IParticleInteraction& interaction_between(const Particle& src,
+            const Particle& target) const {
+        if(src.interaction_type() == NO_INTERACTION_TYPE 
+                || target.interaction_type() == NO_INTERACTION_TYPE) {
+            return src.interaction();
+        }
+        return pair_interaction(src.interaction_type(), target.interaction_type());
+    }
+
+private:
+    void update_max_cutoff_radius(InteractionTypeId source);
+
+    std::vector<std::unique_ptr<IParticleInteraction>> m_types;
+    std::vector<std::unique_ptr<IParticleInteraction>> m_pair_overrides;
+    //Row major by source type.
+    std::vector<const IParticleInteraction*> m_pair_table;
+    std::vector<PositionType> m_max_cutoff_radius;
+};
+
+#endif
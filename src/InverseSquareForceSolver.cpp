@@ -0,0 +1,49 @@
+#include "InverseSquareForceSolver.h"
+
+#include "InverseSquareKernel.h"
+#include "Particle.h"
+#include "Grid.h"
+
+InverseSquareForceSolver::InverseSquareForceSolver(ChargeIndexType charge_index):
+    m_charge_index(charge_index) {
+}
+ 
+ForceType InverseSquareForceSolver::compute_force(const Particle& particle, 
+        const SpatialVector& position, const SpatialVector& velocity,
+        const Simulation& simulation, const Grid& grid) const {
+    auto& store = grid.particle_store();
+    if(store.num_charge_channels() <= static_cast<std::size_t>(m_charge_index)) {
+        return ForceType::zero();
+    }
+
+    InverseSquareSources sources{store.x(), store.y(), 
+        store.charges(m_charge_index), store.radius(), store.size()};
+
+    auto force_sum = [&grid](const SpatialVector& position, 
+            const InverseSquareSources& sources) {
+        return grid.is_periodic()
+            ? inverse_square_force_sum_periodic(position, sources, 
+                    SpatialVector(grid.width(), grid.height()))
+            : inverse_square_force_sum(position, sources);
+    };
+
+    //The particle itself is skipped by splitting the sources around its own
+    //entry. Its stored position need not match the updated position.
+    auto force = ForceType::zero();
+    if(&particle.store() == &store) {
+        auto self_idx = particle.store_index();
+        auto before = sources;
+        before.count = self_idx;
+        auto after = sources;
+        after.x += self_idx + 1;
+        after.y += self_idx + 1;
+        after.charge += self_idx + 1;
+        after.radius += self_idx + 1;
+        after.count = store.size() - self_idx - 1;
+        force = force_sum(position, before) + force_sum(position, after);
+    } else {
+        force = force_sum(position, sources);
+    }
+
+    return force * particle.get_charge(m_charge_index);
+}
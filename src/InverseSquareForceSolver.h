@@ -0,0 +1,34 @@
+#ifndef INVERSESQUAREFORCESOLVER_H_
+#define INVERSESQUAREFORCESOLVER_H_
+
+#include "IForceSolver.h"
+
+//All-pairs solver for the clamped inverse square law
+//  F = q_i*q_j / max(r^2, radius_j^2) * r_hat
+//evaluated with the vectorized kernel over the grid's ParticleStore.
+//The law is fixed, so the particles' own interactions are not consulted; use
+//it only for populations whose interaction is this law.
+class InverseSquareForceSolver: public IForceSolver {
+public:
+    InverseSquareForceSolver(ChargeIndexType charge_index = 0);
+    virtual ~InverseSquareForceSolver() = default;
+
+    InverseSquareForceSolver(const InverseSquareForceSolver& other) = delete;
+    InverseSquareForceSolver(InverseSquareForceSolver&& other) noexcept = default;
+    InverseSquareForceSolver& operator =(const InverseSquareForceSolver& other) = delete;
+    InverseSquareForceSolver& operator =(InverseSquareForceSolver&& other) noexcept = default;
+
+    virtual void prepare_frame(const Simulation& simulation, 
+            const Grid& grid) override {}
+
+    virtual ForceType compute_force(const Particle& particle, 
+            const SpatialVector& position, const SpatialVector& velocity,
+            const Simulation& simulation, const Grid& grid) const override;
+
+    ChargeIndexType charge_index() const {return m_charge_index;}
+
+private:
+    ChargeIndexType m_charge_index = 0;
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "InverseSquareKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+//The vector kernels load and sum packed floats, so they are only built when
+//both storage and accumulation are single precision.
+#if (defined(__x86_64__) || defined(__i386__)) \
+        && !defined(PRECISION_DOUBLE) && !defined(PRECISION_MIXED)
+#include <immintrin.h>
+#define PS_X86_KERNELS
+#endif
+
+namespace {
+
+using KernelFn = ForceType (*)(const SpatialVector&, const InverseSquareSources&);
+
+struct KernelEntry {
+    KernelFn fn;
+    const char* name;
+};
+
+template<typename T>
+inline void accumulate_scalar(T px, T py, const InverseSquareSources& sources,
+        std::size_t begin, T& fx, T& fy) {
+    for(auto i = begin; i < sources.count; ++i) {
+        T rx = sources.x[i] - px;
+        T ry = sources.y[i] - py;
+        T dist_squared = rx*rx + ry*ry;
+        if(dist_squared > T(0)) {
+            T radius_squared = sources.radius[i] * sources.radius[i];
+            T scale = sources.charge[i] 
+                / (std::max(dist_squared, radius_squared) * std::sqrt(dist_squared));
+            fx += scale * rx;
+            fy += scale * ry;
+        }
+    }
+}
+
+#ifdef PS_X86_KERNELS
+
+__attribute__((target("sse2")))
+ForceType force_sum_sse(const SpatialVector& position,
+        const InverseSquareSources& sources) {
+    auto px = _mm_set1_ps(position.x);
+    auto py = _mm_set1_ps(position.y);
+    auto zero = _mm_setzero_ps();
+    auto fx = zero;
+    auto fy = zero;
+
+    std::size_t i = 0;
+    for(; i + 4 <= sources.count; i += 4) {
+        auto rx = _mm_sub_ps(_mm_loadu_ps(sources.x + i), px);
+        auto ry = _mm_sub_ps(_mm_loadu_ps(sources.y + i), py);
+        auto radius = _mm_loadu_ps(sources.radius + i);
+        auto dist_squared = _mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry));
+        auto clamped = _mm_max_ps(dist_squared, _mm_mul_ps(radius, radius));
+        auto scale = _mm_div_ps(_mm_loadu_ps(sources.charge + i),
+                _mm_mul_ps(clamped, _mm_sqrt_ps(dist_squared)));
+        scale = _mm_and_ps(scale, _mm_cmpgt_ps(dist_squared, zero));
+        fx = _mm_add_ps(fx, _mm_mul_ps(scale, rx));
+        fy = _mm_add_ps(fy, _mm_mul_ps(scale, ry));
+    }
+
+    alignas(16) float lanes_x[4];
+    alignas(16) float lanes_y[4];
+    _mm_store_ps(lanes_x, fx);
+    _mm_store_ps(lanes_y, fy);
+    float sum_x = (lanes_x[0] + lanes_x[1]) + (lanes_x[2] + lanes_x[3]);
+    float sum_y = (lanes_y[0] + lanes_y[1]) + (lanes_y[2] + lanes_y[3]);
+
+    accumulate_scalar<float>(position.x, position.y, sources, i, sum_x, sum_y);
+    return ForceType(sum_x, sum_y);
+}
+
+__attribute__((target("avx2")))
+ForceType force_sum_avx2(const SpatialVector& position,
+        const InverseSquareSources& sources) {
+    auto px = _mm256_set1_ps(position.x);
+    auto py = _mm256_set1_ps(position.y);
+    auto zero = _mm256_setzero_ps();
+    auto fx = zero;
+    auto fy = zero;
+
+    std::size_t i = 0;
+    for(; i + 8 <= sources.count; i += 8) {
+        auto rx = _mm256_sub_ps(_mm256_loadu_ps(sources.x + i), px);
+        auto ry = _mm256_sub_ps(_mm256_loadu_ps(sources.y + i), py);
+        auto radius = _mm256_loadu_ps(sources.radius + i);
+        auto dist_squared = _mm256_add_ps(_mm256_mul_ps(rx, rx), 
+                _mm256_mul_ps(ry, ry));
+        auto clamped = _mm256_max_ps(dist_squared, _mm256_mul_ps(radius, radius));
+        auto scale = _mm256_div_ps(_mm256_loadu_ps(sources.charge + i),
+                _mm256_mul_ps(clamped, _mm256_sqrt_ps(dist_squared)));
+        scale = _mm256_and_ps(scale, 
+                _mm256_cmp_ps(dist_squared, zero, _CMP_GT_OQ));
+        fx = _mm256_add_ps(fx, _mm256_mul_ps(scale, rx));
+        fy = _mm256_add_ps(fy, _mm256_mul_ps(scale, ry));
+    }
+
+    alignas(32) float lanes_x[8];
+    alignas(32) float lanes_y[8];
+    _mm256_store_ps(lanes_x, fx);
+    _mm256_store_ps(lanes_y, fy);
+    float sum_x = 0;
+    float sum_y = 0;
+    for(int lane = 0; lane < 8; ++lane) {
+        sum_x += lanes_x[lane];
+        sum_y += lanes_y[lane];
+    }
+
+    accumulate_scalar<float>(position.x, position.y, sources, i, sum_x, sum_y);
+    return ForceType(sum_x, sum_y);
+}
+
+__attribute__((target("avx512f")))
+ForceType force_sum_avx512(const SpatialVector& position,
+        const InverseSquareSources& sources) {
+    auto px = _mm512_set1_ps(position.x);
+    auto py = _mm512_set1_ps(position.y);
+    auto zero = _mm512_setzero_ps();
+    auto fx = zero;
+    auto fy = zero;
+
+    std::size_t i = 0;
+    for(; i + 16 <= sources.count; i += 16) {
+        auto rx = _mm512_sub_ps(_mm512_loadu_ps(sources.x + i), px);
+        auto ry = _mm512_sub_ps(_mm512_loadu_ps(sources.y + i), py);
+        auto radius = _mm512_loadu_ps(sources.radius + i);
+        auto dist_squared = _mm512_add_ps(_mm512_mul_ps(rx, rx), 
+                _mm512_mul_ps(ry, ry));
+        auto clamped = _mm512_max_ps(dist_squared, _mm512_mul_ps(radius, radius));
+        auto nonzero = _mm512_cmp_ps_mask(dist_squared, zero, _CMP_GT_OQ);
+        auto scale = _mm512_maskz_div_ps(nonzero, 
+                _mm512_loadu_ps(sources.charge + i),
+                _mm512_mul_ps(clamped, _mm512_sqrt_ps(dist_squared)));
+        fx = _mm512_add_ps(fx, _mm512_mul_ps(scale, rx));
+        fy = _mm512_add_ps(fy, _mm512_mul_ps(scale, ry));
+    }
+
+    float sum_x = _mm512_reduce_add_ps(fx);
+    float sum_y = _mm512_reduce_add_ps(fy);
+
+    accumulate_scalar<float>(position.x, position.y, sources, i, sum_x, sum_y);
+    return ForceType(sum_x, sum_y);
+}
+
+#endif
+
+template<typename T>
+struct KernelSelector {
+    static KernelEntry select() {
+        return {&inverse_square_force_sum_scalar, "scalar"};
+    }
+};
+
+//The vector kernels operate on packed floats, so they are only candidates
+//when forces are summed as float.
+template<>
+struct KernelSelector<float> {
+    static KernelEntry select() {
+#ifdef PS_X86_KERNELS
+        static_assert(std::is_same<ChargeType, float>::value 
+                && std::is_same<QuantityType, float>::value,
+                "SIMD kernels expect float charges and radii");
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f")) {
+            return {&force_sum_avx512, "avx512"};
+        }
+        if(__builtin_cpu_supports("avx2")) {
+            return {&force_sum_avx2, "avx2"};
+        }
+        if(__builtin_cpu_supports("sse2")) {
+            return {&force_sum_sse, "sse2"};
+        }
+#endif
+        return {&inverse_square_force_sum_scalar, "scalar"};
+    }
+};
+
+const KernelEntry& selected_kernel() {
+    static const KernelEntry entry = KernelSelector<AccumulationType>::select();
+    return entry;
+}
+
+}
+
+ForceType inverse_square_force_sum(const SpatialVector& position,
+        const InverseSquareSources& sources) {
+    return selected_kernel().fn(position, sources);
+}
+ 
+ForceType inverse_square_force_sum_scalar(const SpatialVector& position,
+        const InverseSquareSources& sources) {
+    AccumulationType sum_x = 0;
+    AccumulationType sum_y = 0;
+    accumulate_scalar<AccumulationType>(position.x, position.y, sources, 0, 
+            sum_x, sum_y);
+    return ForceType(AccumulatorVector(sum_x, sum_y));
+}
+ 
+ForceType inverse_square_force_sum_periodic(const SpatialVector& position,
+        const InverseSquareSources& sources, const SpatialVector& period) {
+    AccumulationType sum_x = 0;
+    AccumulationType sum_y = 0;
+    for(std::size_t i = 0; i < sources.count; ++i) {
+        AccumulationType rx = sources.x[i] - position.x;
+        AccumulationType ry = sources.y[i] - position.y;
+        rx -= period.x * std::round(rx / period.x);
+        ry -= period.y * std::round(ry / period.y);
+        AccumulationType dist_squared = rx*rx + ry*ry;
+        if(dist_squared > 0) {
+            AccumulationType radius_squared = sources.radius[i] * sources.radius[i];
+            AccumulationType scale = sources.charge[i] 
+                / (std::max(dist_squared, radius_squared) * std::sqrt(dist_squared));
+            sum_x += scale * rx;
+            sum_y += scale * ry;
+        }
+    }
+    return ForceType(AccumulatorVector(sum_x, sum_y));
+}
+ 
+const char* inverse_square_kernel_name() {
+    return selected_kernel().name;
+}
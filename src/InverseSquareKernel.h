@@ -0,0 +1,36 @@
+#ifndef PS_INVERSE_SQUARE_KERNEL_H_
+#define PS_INVERSE_SQUARE_KERNEL_H_
+
+#include <cstddef>
+
+#include "CommonTypes.h"
+#include "Vector2.h"
+
+//Contiguous source arrays for the inverse square kernel.
+struct InverseSquareSources {
+    const PositionType* x;
+    const PositionType* y;
+    const ChargeType* charge;
+    const QuantityType* radius;
+    std::size_t count;
+};
+
+//Sums q_j / max(|r|^2, radius_j^2) * r / |r| with r = source_j - position over
+//all sources, which is the clamped inverse square law scaled by the target
+//charge afterwards. Sources at zero distance contribute nothing. The SIMD
+//width (SSE, AVX2 or AVX-512) is picked once at runtime.
+ForceType inverse_square_force_sum(const SpatialVector& position,
+        const InverseSquareSources& sources);
+
+ForceType inverse_square_force_sum_scalar(const SpatialVector& position,
+        const InverseSquareSources& sources);
+
+//As inverse_square_force_sum, with r taken to the nearest periodic image of
+//each source in a box of the given size. Always scalar.
+ForceType inverse_square_force_sum_periodic(const SpatialVector& position,
+        const InverseSquareSources& sources, const SpatialVector& period);
+
+//Name of the kernel selected for this machine.
+const char* inverse_square_kernel_name();
+
+#endif
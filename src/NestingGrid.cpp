@@ -0,0 +1,91 @@
+#include "NestingGrid.h"
+
+NestingGrid::NestingGrid(PositionType width, PositionType height,
+        int xres, int yres, int num_layers):
+    Grid(width, height, xres, yres)
+{
+    build_layers(num_layers);
+}
+ 
+void NestingGrid::refresh_layers() {
+    for(auto& layer : m_layers) {
+        layer.clear();
+    }
+
+    auto& base = m_layers[0];
+    for(int y = 0; y < base.yres(); ++y) {
+        for(int x = 0; x < base.xres(); ++x) {
+            auto& aggregate = base.cell(x, y).aggregate();
+            for(auto& item : cell(x, y)) {
+                aggregate.add(item.particle());
+            }
+        }
+    }
+    base.build_cell_particles();
+
+    for(std::size_t i = 1; i < m_layers.size(); ++i) {
+        auto& finer = m_layers[i-1];
+        auto& layer = m_layers[i];
+        for(int y = 0; y < finer.yres(); ++y) {
+            for(int x = 0; x < finer.xres(); ++x) {
+                layer.cell(x / 2, y / 2).aggregate().merge(
+                        finer.cell(x, y).aggregate());
+            }
+        }
+        layer.build_cell_particles();
+    }
+}
+ 
+std::ostream& NestingGrid::print_particle_density(std::ostream& stream, 
+        int layer_num) const {
+    const auto& layer = m_layers[layer_num];
+
+    for(int y = 0; y < layer.yres(); ++y) {
+        for(int x = 0; x < layer.xres(); ++x) {
+            stream << layer.cell(x, y).particle_num() << " ";
+        }
+        stream << "\n";
+    }
+    return stream;
+}
+ 
+void NestingGrid::build_layers(int num_layers) {
+    int layer_xres = xres();
+    int layer_yres = yres();
+    auto layer_dx = dx();
+    auto layer_dy = dy();
+
+    m_layers.emplace_back(layer_dx, layer_dy, layer_xres, layer_yres);
+    while((num_layers <= 0 && (layer_xres > 1 || layer_yres > 1))
+            || static_cast<int>(m_layers.size()) < num_layers) {
+        layer_xres = (layer_xres + 1) / 2;
+        layer_yres = (layer_yres + 1) / 2;
+        layer_dx *= 2;
+        layer_dy *= 2;
+
+        m_layers.emplace_back(layer_dx, layer_dy, layer_xres, layer_yres);
+    }
+}
+ 
+NestingGridLayer::NestingGridLayer(PositionType dx, PositionType dy, 
+        int xres, int yres):
+    m_xres(xres), m_yres(yres), m_dx(dx), m_dy(dy)
+{
+    m_cells.resize(m_xres*m_yres);
+}
+ 
+void NestingGridLayer::clear() {
+    for(auto& cell : m_cells) {
+        cell.aggregate().clear();
+    }
+    m_cell_particles.clear();
+    m_cell_store->clear();
+}
+ 
+void NestingGridLayer::build_cell_particles() {
+    m_cell_particles.reserve(m_cells.size());
+    m_cell_store->reserve(m_cells.size());
+    for(auto& cell : m_cells) {
+        m_cell_particles.push_back(cell.aggregate().make_particle(*m_cell_store));
+    }
+}
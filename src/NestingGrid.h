@@ -2,72 +2,47 @@
 #define PS_NESTING_GRID_H_
 
 #include <cassert>
+#include <memory>
 #include <vector>
-#include <unordered_map>
-#include <unordered_set>
+#include <ostream>
 
 #include "CommonTypes.h"
 #include "Vector2.h"
+#include "Grid.h"
+#include "Particle.h"
+#include "ParticleAggregate.h"
 
-template<typename Elem>
-class WorldUpdater;
-
-template<typename Elem>
-class GridCell {
+class NestingGridCell {
 public:
-    GridCell() {};
-    ~GridCell() = default;
+    NestingGridCell() {};
+    ~NestingGridCell() = default;
 
-    GridCell(const GridCell& other) = delete;
-    GridCell(GridCell&& other) noexcept = default;
-    GridCell& operator =(const GridCell& other) = delete;
-    GridCell& operator =(GridCell&& other) noexcept = default;
+    NestingGridCell(const NestingGridCell& other) = delete;
+    NestingGridCell(NestingGridCell&& other) noexcept = default;
+    NestingGridCell& operator =(const NestingGridCell& other) = delete;
+    NestingGridCell& operator =(NestingGridCell&& other) noexcept = default;
 
     int particle_num() const {
-        return m_particle_num;
+        return m_aggregate.count();
     }
 
-private:
-    SpatialVector m_force_center = {0, 0};
-    ForceType m_force_strength = 0;
-    int m_particle_num = 0;
-};
-
-template<typename Elem>
-class PopulatedGridCell {
-public:
-    using iterator = typename std::vector<Elem*>::iterator;
-    using const_iterator = typename std::vector<Elem*>::const_iterator;    
-
-    PopulatedGridCell() {};
-    ~PopulatedGridCell() = default;
-
-    PopulatedGridCell(const PopulatedGridCell& other) = delete;
-    PopulatedGridCell(PopulatedGridCell&& other) noexcept = default;
-    PopulatedGridCell& operator =(const PopulatedGridCell& other) = delete;
-    PopulatedGridCell& operator =(PopulatedGridCell&& other) noexcept = default;
-
-    iterator insert(Elem* elem) {
-        m_elements.push_back(elem);
-        return m_elements.end()-1;
-    }
+    const ParticleAggregate& aggregate() const {return m_aggregate;}
+    ParticleAggregate& aggregate() {return m_aggregate;}
 
-    std::size_t num_elems() const {
-        return m_elements.size();
-    }
+    SpatialVector force_center() const {return m_aggregate.center();}
 
 private:
-    std::vector<Elem*> m_elements;
+    ParticleAggregate m_aggregate;
 };
 
-template<typename Elem>
+//One level of aggregated cells. Level 0 matches the resolution of the
+//underlying Grid and each following level halves the resolution.
 class NestingGridLayer {
 public:
-    using iterator = typename std::vector<GridCell<Elem>>::iterator;
-    using const_iterator = typename std::vector<GridCell<Elem>>::const_iterator;
+    using iterator = std::vector<NestingGridCell>::iterator;
+    using const_iterator = std::vector<NestingGridCell>::const_iterator;
 
-    NestingGridLayer(PositionType width, PositionType height, PositionType xres,
-            PositionType yres);
+    NestingGridLayer(PositionType dx, PositionType dy, int xres, int yres);
     ~NestingGridLayer() = default;
 
     NestingGridLayer(const NestingGridLayer& other) = delete;
@@ -75,13 +50,28 @@ public:
     NestingGridLayer& operator =(const NestingGridLayer& other) = delete;
     NestingGridLayer& operator =(NestingGridLayer&& other) noexcept = default;
 
-    GridCell<Elem>& operator [](std::size_t idx) {
+    NestingGridCell& operator [](std::size_t idx) {
         return m_cells[idx];
     }
-    const GridCell<Elem>& operator [](std::size_t idx) const {
+    const NestingGridCell& operator [](std::size_t idx) const {
         return m_cells[idx];
     }
 
+    NestingGridCell& cell(int x, int y) {
+        assert(x < m_xres && y < m_yres);
+        return m_cells[x + y*m_xres];
+    }
+    const NestingGridCell& cell(int x, int y) const {
+        assert(x < m_xres && y < m_yres);
+        return m_cells[x + y*m_xres];
+    }
+
+    //Stand-in particle for the contents of a cell, valid after
+    //NestingGrid::refresh_layers.
+    const Particle& cell_particle(int x, int y) const {
+        return m_cell_particles[x + y*m_xres];
+    }
+
     iterator begin() {
         return m_cells.begin();
     }
@@ -102,11 +92,11 @@ public:
         return m_cells.cend();
     }
 
-    PositionType xres() const {
+    int xres() const {
         return m_xres;
     }
-    PositionType yres() const {
-        return m_xres;
+    int yres() const {
+        return m_yres;
     }
     PositionType dx() const {
         return m_dx;
@@ -115,223 +105,56 @@ public:
         return m_dy;
     }
 
-    constexpr std::size_t num_cells() const {
-        return m_xres*m_yres;
+    std::size_t num_cells() const {
+        return m_cells.size();
     }
 
+    void clear();
+    void build_cell_particles();
+
 private:
-    std::vector<GridCell<Elem>> m_cells;
+    std::vector<NestingGridCell> m_cells;
+    std::vector<Particle> m_cell_particles;
+    //State of m_cell_particles, held by pointer since they refer to it.
+    std::unique_ptr<ParticleStore> m_cell_store = 
+        std::make_unique<ParticleStore>();
 
-    PositionType m_width;
-    PositionType m_height;
-    PositionType m_xres;
-    PositionType m_yres; 
+    int m_xres;
+    int m_yres; 
 
     PositionType m_dx;
     PositionType m_dy;
 };
 
-template<typename Elem>
-class NestingGrid {
-
-template<typename U>
-friend class WorldUpdater;
-
+//A Grid that additionally keeps a pyramid of aggregated charge centers. The
+//layers are refreshed once per frame by refresh_layers and are used by
+//NestingGridForceSolver to approximate far away cells.
+class NestingGrid: public Grid {
 public:
-    using iterator = typename std::vector<GridCell<Elem>>::iterator;
-    using const_iterator = typename std::vector<GridCell<Elem>>::const_iterator;
-
-    NestingGrid(PositionType width, PositionType height, PositionType xres,
-            PositionType yres, int num_layers);
+    //num_layers <= 0 builds layers until a single cell covers the grid.
+    NestingGrid(PositionType width, PositionType height, int xres,
+            int yres, int num_layers = 0);
     ~NestingGrid() = default;
 
     NestingGrid(const NestingGrid& other) = delete;
-    NestingGrid(NestingGrid&& other) noexcept = delete;
+    NestingGrid(NestingGrid&& other) noexcept = default;
     NestingGrid& operator =(const NestingGrid& other) = delete;
-    NestingGrid& operator =(NestingGrid&& other) noexcept = delete;
-
-    PopulatedGridCell<Elem>& add_element(Elem element) {
-        auto idx = position_to_cell(element.position());    
-        auto& cell = m_cells[idx];
-        auto id = element.id();
-        auto& particle = *m_elements.
-            insert(std::make_pair(id, std::move(element))).first;
-        cell.insert(&particle.second);
-        return cell;
-    }
-
-    PositionType xres() const {
-        return m_xres;
-    }
-    PositionType yres() const {
-        return m_xres;
-    }
-    PositionType dx() const {
-        return m_dx;
-    }
-    PositionType dy() const {
-        return m_dy;
-    }
-
-    constexpr std::size_t position_to_cell(const SpatialVector& pos) const {
-        auto x = pos.x / m_dx; 
-        auto y = pos.y / m_dy;
+    NestingGrid& operator =(NestingGrid&& other) noexcept = default;
 
-        assert(x < m_xres);
-        assert(y < m_yres);
-        assert(x >= 0);
-        assert(y >= 0);
+    std::size_t num_layers() const {return m_layers.size();}
+    NestingGridLayer& layer(std::size_t idx) {return m_layers[idx];}
+    const NestingGridLayer& layer(std::size_t idx) const {return m_layers[idx];}
 
-        return x + y*m_width;
-    }
+    //Recomputes the aggregates of every layer from the current particle
+    //positions and cell membership.
+    void refresh_layers();
 
-    std::ostream& print_particle_density(std::ostream& stream, int layer_num) {
-        const auto& layer = m_layers[layer_num];
-        auto xres = layer.xres();
-        auto yres = layer.yres();
-
-        for(int y = 0; y < yres; ++y) {
-            for(int x = 0; x < xres; ++x) {
-                stream << layer[x + y*xres].particle_num() << " ";
-            }
-            stream << "\n";
-        }
-        return stream;
-    }
-
-    void begin_update() {
-
-    }
+    std::ostream& print_particle_density(std::ostream& stream, int layer_num) const;
 
 private:
     void build_layers(int num_layers);
 
-    void update_complete(WorldUpdater<Elem>& updater) {
-        for(auto& particle: updater.particles()) {
-              
-        }
-    }
-
-    std::vector<NestingGridLayer<Elem>> m_layers;
-    std::vector<PopulatedGridCell<Elem>> m_cells;
-    std::unordered_map<int, Elem> m_elements;
-
-    PositionType m_width;
-    PositionType m_height;
-    PositionType m_xres;
-    PositionType m_yres; 
-
-    PositionType m_dx;
-    PositionType m_dy;
+    std::vector<NestingGridLayer> m_layers;
 };
 
-template<typename Elem>
-class WorldUpdater {
-public:
-    WorldUpdater(std::vector<PopulatedGridCell<Elem>> values, 
-            NestingGrid<Elem>& grid):
-        m_grid(&grid) 
-    {}
-
-    ~WorldUpdater() {
-        finalize();
-    }
-
-    WorldUpdater(const WorldUpdater& other) = delete;
-    WorldUpdater(WorldUpdater&& other) noexcept {
-        if(m_grid != nullptr) {
-            finalize();
-        }
-        std::swap(m_grid, other.m_grid);
-        m_cells = std::move(other.m_cells);
-    }
-    WorldUpdater& operator =(const WorldUpdater& other) = delete;
-    WorldUpdater& operator =(WorldUpdater&& other) noexcept {
-        if(m_grid != nullptr) {
-            finalize();
-        }
-        std::swap(m_grid, other.m_grid);
-        m_cells = std::move(other.m_cells);
-        return *this;
-    }
-
-    std::vector<PopulatedGridCell<Elem>>& cells() {
-        return m_cells;
-    }
-
-    PopulatedGridCell<Elem>& operator [](std::size_t idx) {
-        assert(m_grid != nullptr);
-        return m_cells[idx];
-    }
-    const PopulatedGridCell<Elem>& operator [](std::size_t idx) const {
-        assert(m_grid != nullptr);
-        return m_cells[idx];
-    }
-
-    void update_complete() {
-        finalize();
-    }
-
-private:
-    void finalize() {
-        if(m_grid != nullptr) {
-            m_grid->update_complete(*this); 
-            m_grid = nullptr;
-        }
-    }
-
-    std::vector<PopulatedGridCell<Elem>> m_cells;
-    NestingGrid<Elem>* m_grid = nullptr;
-};
-
-template<typename Elem>
-inline NestingGrid<Elem>::NestingGrid(PositionType width, PositionType height,
-        PositionType xres, PositionType yres, int num_layers):
-    m_width(width), m_height(height), m_xres(xres), m_yres(yres),
-    m_dx(width / xres), m_dy(height / yres)
-{
-    build_layers(num_layers);
-}
- 
-template<typename Elem>
-inline void NestingGrid<Elem>::build_layers(int num_layers)
-{
-    PositionType xres = m_xres;
-    PositionType yres = m_yres;
-    for(int i = 0; i < num_layers; ++i) {
-        xres /= 2.0;
-        yres /= 2.0;
-
-        m_layers.emplace_back(m_width, m_height, xres, yres);
-    }
-    m_cells.resize(m_xres*m_yres);
-}
- 
-template<typename Elem>
-inline NestingGridLayer<Elem>::NestingGridLayer(PositionType width, PositionType height, 
-        PositionType xres, PositionType yres):
-    m_width(width), m_height(height), m_xres(xres), m_yres(yres),
-    m_dx(width / xres), m_dy(height / yres)
-{
-    m_cells.resize(m_xres*m_yres);
-}
-
-template<typename Elem>
-typename NestingGridLayer<Elem>::iterator begin(NestingGridLayer<Elem>& target) {
-    return target.begin();
-}
-template<typename Elem>
-typename NestingGridLayer<Elem>::const_iterator begin(const NestingGridLayer<Elem>& target) {
-    return target.begin();
-}
-
-template<typename Elem>
-typename NestingGridLayer<Elem>::iterator end(NestingGridLayer<Elem>& target) {
-    return target.end();
-}
-template<typename Elem>
-typename NestingGridLayer<Elem>::const_iterator end(const NestingGridLayer<Elem>& target) {
-    return target.end();
-}
- 
 #endif
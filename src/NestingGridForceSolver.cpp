@@ -0,0 +1,77 @@
+#include "NestingGridForceSolver.h"
+
+#include <algorithm>
+
+#include "NestingGrid.h"
+
+NestingGridForceSolver::NestingGridForceSolver(const NestingGrid& grid, 
+        PositionType opening_ratio):
+    m_grid(&grid), m_opening_ratio(opening_ratio) {
+}
+ 
+ForceType NestingGridForceSolver::compute_force(const Particle& particle, 
+        const SpatialVector& position, const SpatialVector& velocity,
+        const Simulation& simulation, const Grid& grid) const {
+    auto force = AccumulatorVector::zero();
+
+    auto top_level = m_grid->num_layers() - 1;
+    auto& top = m_grid->layer(top_level);
+    for(int y = 0; y < top.yres(); ++y) {
+        for(int x = 0; x < top.xres(); ++x) {
+            accumulate_cell_force(force, particle, position, velocity, 
+                    top_level, x, y);
+        }
+    }
+
+    return ForceType(force);
+}
+ 
+void NestingGridForceSolver::accumulate_cell_force(AccumulatorVector& force, 
+        const Particle& particle, const SpatialVector& position, 
+        const SpatialVector& velocity, std::size_t level, int x, int y) const {
+    const auto& layer = m_grid->layer(level);
+    const auto& cell = layer.cell(x, y);
+    if(cell.particle_num() == 0) {
+        return;
+    }
+
+    auto own_position = particle.position();
+    auto contains_particle = 
+        own_position.x >= x * layer.dx() && own_position.x < (x+1) * layer.dx() 
+        && own_position.y >= y * layer.dy() && own_position.y < (y+1) * layer.dy();
+
+    if(!contains_particle) {
+        auto& cell_particle = layer.cell_particle(x, y);
+        auto size = std::max(layer.dx(), layer.dy());
+        auto image = m_grid->nearest_image(position, cell_particle.position());
+        auto dist_squared = (cell_particle.position() - image).magnitude_squared();
+        //Aggregates have no type, so the particle's own interaction applies.
+        if(size * size < m_opening_ratio * m_opening_ratio * dist_squared) {
+            force += AccumulatorVector(
+                    particle.compute_force(cell_particle, image, velocity));
+            return;
+        }
+    }
+
+    if(level == 0) {
+        for(auto& item : m_grid->cell(x, y)) {
+            auto& target = item.particle();
+            if(&target == &particle) continue;
+            force += AccumulatorVector(
+                m_grid->interactions().interaction_between(particle, target)
+                .compute_force(target, particle, 
+                    m_grid->nearest_image(position, target.position()), velocity));
+        }
+        return;
+    }
+
+    const auto& finer = m_grid->layer(level - 1);
+    auto x_end = std::min(2*x + 2, finer.xres());
+    auto y_end = std::min(2*y + 2, finer.yres());
+    for(int child_y = 2*y; child_y < y_end; ++child_y) {
+        for(int child_x = 2*x; child_x < x_end; ++child_x) {
+            accumulate_cell_force(force, particle, position, velocity, 
+                    level - 1, child_x, child_y);
+        }
+    }
+}
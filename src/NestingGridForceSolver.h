@@ -0,0 +1,43 @@
+#ifndef NESTINGGRIDFORCESOLVER_H_
+#define NESTINGGRIDFORCESOLVER_H_
+
+#include "IForceSolver.h"
+
+class NestingGrid;
+
+//Evaluates forces using the aggregate layers of a NestingGrid. Cells are
+//visited from the coarsest layer down; a cell is approximated by its
+//aggregate once (cell size / distance) drops below the opening ratio, and
+//cells that are still too close at the finest layer are summed exactly.
+//The layers are only read; whoever owns the grid refreshes them before
+//forces are prepared, as Simulation does in a NESTING_GRID build.
+class NestingGridForceSolver: public IForceSolver {
+public:
+    NestingGridForceSolver(const NestingGrid& grid, PositionType opening_ratio = 0.5);
+    virtual ~NestingGridForceSolver() = default;
+
+    NestingGridForceSolver(const NestingGridForceSolver& other) = delete;
+    NestingGridForceSolver(NestingGridForceSolver&& other) noexcept = default;
+    NestingGridForceSolver& operator =(const NestingGridForceSolver& other) = delete;
+    NestingGridForceSolver& operator =(NestingGridForceSolver&& other) noexcept = default;
+
+    virtual void prepare_frame(const Simulation& simulation, 
+            const Grid& grid) override {}
+
+    virtual ForceType compute_force(const Particle& particle, 
+            const SpatialVector& position, const SpatialVector& velocity,
+            const Simulation& simulation, const Grid& grid) const override;
+
+    PositionType opening_ratio() const {return m_opening_ratio;}
+    void set_opening_ratio(PositionType value) {m_opening_ratio = value;}
+
+private:
+    void accumulate_cell_force(AccumulatorVector& force, const Particle& particle,
+            const SpatialVector& position, const SpatialVector& velocity,
+            std::size_t level, int x, int y) const;
+
+    const NestingGrid* m_grid;
+    PositionType m_opening_ratio = 0.5;
+};
+
+#endif
@@ -1,3 +1,188 @@
 #include "Particle.h"
 
+#include <cstdint>
+
+#include "SimulationSnapshot.h"
+
 int Particle::m_next_id = 0;
+
+Particle::Particle(QuantityType radius, QuantityType mass,
+        const Vector2t& position, const Vector2t& velocity,
+        std::size_t num_charges):
+    m_id(m_next_id++) {
+    own_new_entry(num_charges);
+    set_position(position);
+    m_store->set_vector(ParticleStore::VX, m_index, velocity);
+    m_store->set_vector(ParticleStore::NEXT_VX, m_index, velocity);
+    m_store->value(ParticleStore::MASS, m_index) = mass;
+    set_radius(radius);
+}
+ 
+Particle::Particle(SnapshotTag):
+    m_id(-1) {
+    own_new_entry(0);
+}
+ 
+Particle Particle::make_aggregate(ParticleStore& store, QuantityType radius,
+        QuantityType mass, const Vector2t& position,
+        const std::vector<ChargeType>& charges) {
+    store.reserve_charge_channels(charges.size());
+    Particle particle(store, store.push_back(), -1);
+    particle.m_charge_count = static_cast<std::uint32_t>(charges.size());
+    particle.set_position(position);
+    store.value(ParticleStore::MASS, particle.m_index) = mass;
+    particle.set_radius(radius);
+    for(std::size_t i = 0; i < charges.size(); ++i) {
+        particle.set_charge(i, charges[i]);
+    }
+    return particle;
+}
+ 
+Particle::Particle(const Particle& other):
+    m_id(other.m_id) {
+    own_new_entry(other.m_charge_count);
+    copy_state(other);
+}
+ 
+Particle::Particle(Particle&& other) noexcept:
+    m_store(other.m_store), m_interaction(other.m_interaction),
+    m_index(other.m_index), m_id(other.m_id),
+    m_timestep_level(other.m_timestep_level),
+    m_interaction_type(other.m_interaction_type),
+    m_charge_count(other.m_charge_count), m_owns_store(other.m_owns_store),
+    m_has_cached_acceleration(other.m_has_cached_acceleration) {
+    other.m_store = nullptr;
+    other.m_owns_store = false;
+}
+ 
+Particle& Particle::operator=(const Particle& other) {
+    if(this != &other) {
+        if(m_store == nullptr) {
+            own_new_entry(other.m_charge_count);
+        }
+        copy_state(other);
+        m_id = other.m_id;
+    }
+    return *this;
+}
+ 
+Particle& Particle::operator=(Particle&& other) noexcept {
+    if(this == &other) {
+        return *this;
+    }
+    //An entry in someone else's store, such as a grid's, keeps its place
+    //and only takes over the state.
+    if(other.m_owns_store && (m_store == nullptr || m_owns_store)) {
+        release_store();
+        m_store = other.m_store;
+        m_index = other.m_index;
+        m_owns_store = true;
+        other.m_store = nullptr;
+        other.m_owns_store = false;
+        copy_properties(other);
+    } else {
+        if(m_store == nullptr) {
+            own_new_entry(other.m_charge_count);
+        }
+        copy_state(other);
+    }
+    m_id = other.m_id;
+    return *this;
+}
+ 
+void Particle::move_to(ParticleStore& store) {
+    assert(&store != m_store);
+    store.reserve_charge_channels(m_charge_count);
+    auto idx = store.push_back();
+    store.copy_entry(idx, *m_store, m_index);
+    release_store();
+    m_store = &store;
+    m_index = static_cast<std::uint32_t>(idx);
+}
+ 
+void Particle::update_charge_count(std::size_t count) {
+    m_store->reserve_charge_channels(count);
+    for(auto idx = count; idx < m_charge_count; ++idx) {
+        m_store->value(ParticleStore::FIRST_CHARGE + idx, m_index) = ChargeType(0);
+    }
+    m_charge_count = static_cast<std::uint32_t>(count);
+}
+ 
+void Particle::own_new_entry(std::size_t num_charges) {
+    release_store();
+    m_store = new ParticleStore();
+    m_owns_store = true;
+    m_store->reserve_charge_channels(num_charges);
+    m_index = static_cast<std::uint32_t>(m_store->push_back());
+    m_charge_count = static_cast<std::uint32_t>(num_charges);
+}
+ 
+void Particle::release_store() {
+    if(m_owns_store) {
+        delete m_store;
+    }
+    m_store = nullptr;
+    m_owns_store = false;
+}
+ 
+void Particle::copy_state(const Particle& other) {
+    if(other.m_store != m_store || other.m_index != m_index) {
+        m_store->reserve_charge_channels(other.m_charge_count);
+        m_store->copy_entry(m_index, *other.m_store, other.m_index);
+    }
+    copy_properties(other);
+}
+ 
+void Particle::copy_properties(const Particle& other) {
+    m_interaction = other.m_interaction;
+    m_timestep_level = other.m_timestep_level;
+    m_interaction_type = other.m_interaction_type;
+    m_charge_count = other.m_charge_count;
+    m_has_cached_acceleration = other.m_has_cached_acceleration;
+}
+ 
+void Particle::write_snapshot(SnapshotWriter& writer) const {
+    writer.write(m_id);
+    writer.write(radius());
+    writer.write(mass());
+    writer.write(position());
+    writer.write(next_position());
+    writer.write(velocity());
+    writer.write(next_velocity());
+    writer.write(current_acceleration());
+    writer.write(last_frame_acceleration());
+    writer.write(static_cast<std::uint8_t>(m_has_cached_acceleration));
+    writer.write(m_timestep_level);
+    writer.write(m_interaction_type);
+    writer.write(m_charge_count);
+    for(std::size_t i = 0; i < m_charge_count; ++i) {
+        writer.write(get_charge(i));
+    }
+}
+ 
+Particle Particle::read_snapshot(SnapshotReader& reader) {
+    Particle particle{SnapshotTag{}};
+    auto& store = *particle.m_store;
+    auto idx = particle.m_index;
+    particle.m_id = reader.read<int>();
+    particle.set_radius(reader.read<QuantityType>());
+    store.value(ParticleStore::MASS, idx) = reader.read<QuantityType>();
+    particle.set_position(reader.read<Vector2t>());
+    particle.update_position(reader.read<Vector2t>());
+    store.set_vector(ParticleStore::VX, idx, reader.read<Vector2t>());
+    particle.update_velocity(reader.read<Vector2t>());
+    particle.set_acceleration(reader.read<Vector2t>());
+    store.set_vector(ParticleStore::LAST_AX, idx, reader.read<Vector2t>());
+    particle.m_has_cached_acceleration = reader.read<std::uint8_t>() != 0;
+    particle.m_timestep_level = reader.read<int>();
+    particle.m_interaction_type = reader.read<InteractionTypeId>();
+
+    auto num_charges = reader.read<std::uint32_t>();
+    if(reader.expect(num_charges, sizeof(ChargeType))) {
+        particle.update_charge_count(num_charges);
+        for(std::uint32_t i = 0; i < num_charges; ++i) {
+            particle.set_charge(i, reader.read<ChargeType>());
+        }
+    }
+    return particle;
+}
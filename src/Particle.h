@@ -1,129 +1,161 @@
 #ifndef PS_PARTICLE_H_
 #define PS_PARTICLE_H_
 
-#include <memory>
 #include <cassert>
+#include <cstdint>
 #include <vector>
 
 #include "Vector2.h"
-#include "DoubleBuffered.h"
 #include "CommonTypes.h"
 #include "ParticleInteraction.h"
+#include "ParticleStore.h"
 
+class SnapshotWriter;
+class SnapshotReader;
+
+//The physical state of a particle, its positions, velocities,
+//accelerations, mass, radius and charges, lives in an entry of a
+//ParticleStore. A particle held by a Grid refers to the grid's store. Any
+//other particle owns a store of its own, so particles still behave as
+//values: copies get their own entry, and assigning one particle to another
+//copies the state into the entry of the assigned particle.
 class Particle {
 public:
     using Vector2t = Vector2<QuantityType>;
 
     Particle(QuantityType radius, QuantityType mass,
-            const Vector2t& position=Vector2t::zero(), std::size_t num_charges = 0,
-            std::unique_ptr<IParticleInteraction> interaction = nullptr):
-        m_charges(num_charges), m_position(position), m_radius(radius), 
-        m_mass(mass), m_id(m_next_id++), m_interaction(std::move(interaction))
+            const Vector2t& position=Vector2t::zero(), std::size_t num_charges = 0):
+        Particle(radius, mass, position, Vector2t::zero(), num_charges)
     {}
     Particle(QuantityType radius, QuantityType mass,
-            const Vector2t& position=Vector2t::zero(), 
+            const Vector2t& position=Vector2t::zero(),
             const Vector2t& velocity=Vector2t::zero(),
-            std::size_t num_charges = 0,
-            std::unique_ptr<IParticleInteraction> interaction = nullptr):
-        m_charges(num_charges), m_position(position), m_velocity(velocity),
-        m_radius(radius), m_mass(mass), m_id(m_next_id++), 
-        m_interaction(std::move(interaction))
-    {}
+            std::size_t num_charges = 0);
+
+    ~Particle() {
+        release_store();
+    }
 
-    ~Particle() = default;
+    //Builds a stand-in particle representing a group of particles in a new
+    //entry of store, which must outlive it. Aggregates do not take an id
+    //from the particle counter and have no interaction.
+    static Particle make_aggregate(ParticleStore& store, QuantityType radius,
+            QuantityType mass, const Vector2t& position,
+            const std::vector<ChargeType>& charges);
 
-    Particle(const Particle& other) = default;
-    Particle(Particle&& other) noexcept = default;
-    Particle& operator =(const Particle& other) = default;
-    Particle& operator =(Particle&& other) noexcept = default;
+    Particle(const Particle& other);
+    Particle(Particle&& other) noexcept;
+    Particle& operator =(const Particle& other);
+    Particle& operator =(Particle&& other) noexcept;
+
+    //Moves the state to a new entry at the end of store, which the particle
+    //refers to from then on. The store must outlive the particle.
+    void move_to(ParticleStore& store);
+
+    const ParticleStore& store() const {return *m_store;}
+    std::size_t store_index() const {return m_index;}
 
     void set_position(const Vector2t& position) {
-        m_position.broadcast(position);
+        m_store->set_vector(ParticleStore::X, m_index, position);
+        m_store->set_vector(ParticleStore::NEXT_X, m_index, position);
     }
 
     void update_position(const Vector2t& position) {
-        m_position.set(position);
+        m_store->set_vector(ParticleStore::NEXT_X, m_index, position);
     }
 
     Particle&& update_velocity(const Vector2t& velocity) {
-        m_velocity.set(velocity);
+        m_store->set_vector(ParticleStore::NEXT_VX, m_index, velocity);
         return std::move(*this);
     }
 
-    void apply_update() {
-        m_position.apply_update();
-        m_velocity.apply_update();
-        m_last_frame_acceleration = m_current_frame_acceleration;
-    }
-
-    const Vector2t& position() const {
-        return m_position.get();
+    Vector2t position() const {
+        return m_store->vector(ParticleStore::X, m_index);
     }
-    const Vector2t& next_position() const {
-        return m_position.get_updated_value();
-    }
-    Vector2t& next_position() {
-        return m_position.get_updated_value();
+    Vector2t next_position() const {
+        return m_store->vector(ParticleStore::NEXT_X, m_index);
     }
     void reset_position() {
-        m_position.reset();
-    }
-    const Vector2t& velocity() const {
-        return m_velocity.get(); 
+        update_position(position());
     }
-    const Vector2t& next_velocity() const {
-        return m_velocity.get_updated_value(); 
+    Vector2t velocity() const {
+        return m_store->vector(ParticleStore::VX, m_index);
     }
-    Vector2t& next_velocity() {
-        return m_velocity.get_updated_value(); 
+    Vector2t next_velocity() const {
+        return m_store->vector(ParticleStore::NEXT_VX, m_index);
     }
     void reset_velocity() {
-        m_velocity.reset();
+        update_velocity(velocity());
+    }
+
+    ChargeType get_charge(std::size_t idx) const {
+        assert(idx < m_charge_count);
+        return m_store->value(ParticleStore::FIRST_CHARGE + idx, m_index);
     }
-    std::vector<ChargeType>& charges() {return m_charges;}
-    const std::vector<ChargeType>& charges() const {return m_charges;}
-    ChargeType& get_charge(std::size_t idx) {return m_charges[idx];}
-    const ChargeType& get_charge(std::size_t idx) const {return m_charges[idx];}
-    std::size_t charge_count() const {return m_charges.size();}
+    std::size_t charge_count() const {return m_charge_count;}
 
     Particle&& set_charge(std::size_t idx, ChargeType value) {
-        assert(idx < m_charges.size());
-        m_charges[idx] = value;
+        assert(idx < m_charge_count);
+        m_store->value(ParticleStore::FIRST_CHARGE + idx, m_index) = value;
         return std::move(*this);
     }
 
-    void update_charge_count(std::size_t count) {
-        m_charges.resize(count);
-    }
+    //Keeps existing charges and zeroes any new ones.
+    void update_charge_count(std::size_t count);
 
     QuantityType radius() const {
-        return m_radius;
+        return m_store->value(ParticleStore::RADIUS, m_index);
     }
 
     void set_radius(QuantityType radius) {
-        m_radius = radius;
+        m_store->value(ParticleStore::RADIUS, m_index) = radius;
     }
 
     void set_acceleration(const SpatialVector& value) {
-        m_current_frame_acceleration = value;
+        m_store->set_vector(ParticleStore::AX, m_index, value);
     }
-    const SpatialVector& current_acceleration() const {
-        return m_current_frame_acceleration;
+    SpatialVector current_acceleration() const {
+        return m_store->vector(ParticleStore::AX, m_index);
     }
-    const SpatialVector& last_frame_acceleration() const {
-        return m_last_frame_acceleration;
+    SpatialVector last_frame_acceleration() const {
+        return m_store->vector(ParticleStore::LAST_AX, m_index);
     }
     SpatialVector delta_acceleration() const {
-        return m_last_frame_acceleration-m_current_frame_acceleration;
+        return last_frame_acceleration() - current_acceleration();
+    }
+
+    //Stores the end of step acceleration computed by an integrator so the
+    //next frame can start from it instead of evaluating forces again.
+    void cache_next_acceleration(const SpatialVector& value) {
+        set_acceleration(value);
+        m_has_cached_acceleration = true;
+    }
+    bool has_cached_acceleration() const {
+        return m_has_cached_acceleration;
+    }
+    void invalidate_cached_acceleration() {
+        m_has_cached_acceleration = false;
     }
 
-    const IParticleInteraction& interaction() const {return *m_interaction;}
-    void set_interaction(std::unique_ptr<IParticleInteraction> interaction) {
-        m_interaction = std::move(interaction);
+    //Block timestep level, -1 until a BlockTimestepScheduler assigns one.
+    int timestep_level() const {return m_timestep_level;}
+    void set_timestep_level(int level) {m_timestep_level = level;}
+
+    const IParticleInteraction& interaction() const {
+        assert(m_interaction != nullptr);
+        return *m_interaction;
+    }
+    InteractionTypeId interaction_type() const {return m_interaction_type;}
+    //The interaction is shared and not owned by the particle, normally the
+    //one an InteractionRegistry holds for the type.
+    void set_interaction(InteractionTypeId type,
+            const IParticleInteraction& interaction) {
+        m_interaction_type = type;
+        m_interaction = &interaction;
     }
 
     QuantityType mass() const {
-        return m_mass;
+        return m_store->value(ParticleStore::MASS, m_index);
     }
 
     int id() const {
@@ -135,28 +167,59 @@ public:
         return m_interaction->compute_force(target, *this);
     }
     ForceType compute_force(const Particle& target,
-            const SpatialVector& updated_position, 
+            const SpatialVector& updated_position,
             const SpatialVector& updated_velocity) const {
         assert(m_interaction != nullptr);
-        return m_interaction->compute_force(target, *this, 
+        return m_interaction->compute_force(target, *this,
                 updated_position, updated_velocity);
     }
 
     ForceType acceleration_from_force(const ForceType& force) {
-        return force / m_mass;
+        return force / mass();
     }
 
+    //Full state of the particle including its id. The interaction is only
+    //stored by type, and a read particle has to be given it again.
+    void write_snapshot(SnapshotWriter& writer) const;
+    static Particle read_snapshot(SnapshotReader& reader);
+
+    //Id the next particle created will get.
+    static int next_id() {return m_next_id;}
+    static void set_next_id(int id) {m_next_id = id;}
+
 private:
-    std::vector<ChargeType> m_charges;
-    DoubleBuffered<Vector2t> m_position = Vector2t(0, 0);
-    DoubleBuffered<Vector2t> m_velocity = Vector2t(0, 0);
-    Vector2t m_current_frame_acceleration = Vector2t::zero();
-    Vector2t m_last_frame_acceleration = Vector2t::zero();
-    QuantityType m_radius;
-    QuantityType m_mass;
-    int m_id;
+    friend class Grid;
 
-    std::unique_ptr<IParticleInteraction> m_interaction;
+    struct SnapshotTag {};
+
+    //Entry idx of store, which the particle does not own.
+    Particle(ParticleStore& store, std::size_t idx, int id):
+        m_store(&store), m_index(static_cast<std::uint32_t>(idx)), m_id(id)
+    {}
+    explicit Particle(SnapshotTag);
+
+    //Gives the particle a zeroed entry in a store of its own.
+    void own_new_entry(std::size_t num_charges);
+    void release_store();
+    //Copies everything but the id and the entry, into the entry for
+    //copy_state.
+    void copy_state(const Particle& other);
+    void copy_properties(const Particle& other);
+
+    //Set by a Grid when it moves the entry within its store.
+    void set_store_index(std::size_t idx) {
+        m_index = static_cast<std::uint32_t>(idx);
+    }
+
+    ParticleStore* m_store = nullptr;
+    const IParticleInteraction* m_interaction = nullptr;
+    std::uint32_t m_index = 0;
+    int m_id;
+    int m_timestep_level = -1;
+    InteractionTypeId m_interaction_type = NO_INTERACTION_TYPE;
+    std::uint32_t m_charge_count = 0;
+    bool m_owns_store = false;
+    bool m_has_cached_acceleration = false;
 
     static int m_next_id;
 };
@@ -0,0 +1,64 @@
+#include "ParticleAggregate.h"
+
+#include <algorithm>
+#include <cmath>
+
+void ParticleAggregate::add(const Particle& particle) {
+    auto position = AccumulatorVector(particle.position());
+    auto num_charges = particle.charge_count();
+    if(m_charges.size() < num_charges) {
+        m_charges.resize(num_charges);
+    }
+
+    AccumulationType weight = 0;
+    for(std::size_t i = 0; i < num_charges; ++i) {
+        auto q = particle.get_charge(i);
+        m_charges[i] += q;
+        weight += std::abs(q);
+    }
+
+    m_charge_moment += position * weight;
+    m_charge_weight += weight;
+    m_mass_moment += position * AccumulationType(particle.mass());
+    m_mass += particle.mass();
+    m_max_radius = std::max(m_max_radius, particle.radius());
+    m_count += 1;
+}
+ 
+void ParticleAggregate::merge(const ParticleAggregate& other) {
+    if(m_charges.size() < other.m_charges.size()) {
+        m_charges.resize(other.m_charges.size());
+    }
+    for(std::size_t i = 0; i < other.m_charges.size(); ++i) {
+        m_charges[i] += other.m_charges[i];
+    }
+
+    m_charge_moment += other.m_charge_moment;
+    m_charge_weight += other.m_charge_weight;
+    m_mass_moment += other.m_mass_moment;
+    m_mass += other.m_mass;
+    m_max_radius = std::max(m_max_radius, other.m_max_radius);
+    m_count += other.m_count;
+}
+ 
+void ParticleAggregate::clear() {
+    *this = ParticleAggregate();
+}
+ 
+std::vector<ChargeType> ParticleAggregate::charges() const {
+    return std::vector<ChargeType>(m_charges.begin(), m_charges.end());
+}
+ 
+SpatialVector ParticleAggregate::center() const {
+    if(m_charge_weight > 0) {
+        return SpatialVector(m_charge_moment / m_charge_weight);
+    } else if(m_mass > 0) {
+        return SpatialVector(m_mass_moment / m_mass);
+    }
+    return SpatialVector::zero();
+}
+ 
+Particle ParticleAggregate::make_particle(ParticleStore& store) const {
+    return Particle::make_aggregate(store, m_max_radius, mass(), center(), 
+            charges());
+}
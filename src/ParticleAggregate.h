@@ -0,0 +1,53 @@
+#ifndef PS_PARTICLE_AGGREGATE_H_
+#define PS_PARTICLE_AGGREGATE_H_
+
+#include <vector>
+
+#include "CommonTypes.h"
+#include "Vector2.h"
+#include "Particle.h"
+
+//Accumulates the multipole (monopole) data of a group of particles: total mass,
+//total charge per channel and the charge-weighted center. The result can be
+//turned into a stand-in Particle so far-field groups can be fed through the
+//same IParticleInteraction as individual particles.
+class ParticleAggregate {
+public:
+    ParticleAggregate() = default;
+    ~ParticleAggregate() = default;
+
+    ParticleAggregate(const ParticleAggregate& other) = default;
+    ParticleAggregate(ParticleAggregate&& other) noexcept = default;
+    ParticleAggregate& operator =(const ParticleAggregate& other) = default;
+    ParticleAggregate& operator =(ParticleAggregate&& other) noexcept = default;
+
+    void add(const Particle& particle);
+    void merge(const ParticleAggregate& other);
+    void clear();
+
+    int count() const {return m_count;}
+    bool empty() const {return m_count == 0;}
+    QuantityType mass() const {return QuantityType(m_mass);}
+    QuantityType max_radius() const {return m_max_radius;}
+    std::vector<ChargeType> charges() const;
+
+    //Center of charge, falling back to the center of mass when the group
+    //carries no charge.
+    SpatialVector center() const;
+
+    //Stand-in particle whose state is a new entry of store.
+    Particle make_particle(ParticleStore& store) const;
+
+private:
+    //Totals are kept in AccumulationType, since large groups sum many
+    //small contributions.
+    std::vector<AccumulationType> m_charges;
+    AccumulatorVector m_charge_moment = AccumulatorVector::zero();
+    AccumulatorVector m_mass_moment = AccumulatorVector::zero();
+    AccumulationType m_charge_weight = 0;
+    AccumulationType m_mass = 0;
+    QuantityType m_max_radius = 0;
+    int m_count = 0;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include "ParticleCollisionResolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include "Grid.h"
+#include "Particle.h"
+#include "Simulation.h"
+
+ParticleCollisionResolver::ParticleCollisionResolver(PositionType restitution):
+    m_restitution(restitution) {}
+ 
+void ParticleCollisionResolver::resolve_particle_collisions(Simulation& simulation,
+        Grid& grid) {
+    m_collision_count = 0;
+    auto dt = static_cast<PositionType>(simulation.simulation_time().time_delta());
+
+    PositionType max_radius = 0;
+    PositionType max_displacement = 0;
+    for(auto& item : grid) {
+        auto& particle = item.particle();
+        max_radius = std::max(max_radius, particle.radius());
+        max_displacement = std::max(max_displacement, grid.displacement(
+                    particle.position(), particle.next_position()).magnitude());
+    }
+
+    //Cells are still indexed by the start positions, and two particles can
+    //only touch if those are within the sum of their radii and step
+    //displacements. Bounding the partner's share by the largest values keeps
+    //the reach of a particle small unless it is large or fast itself.
+    auto partner_reach = max_radius + max_displacement;
+    auto xres = static_cast<int>(grid.xres());
+    auto yres = static_cast<int>(grid.yres());
+    auto periodic = grid.is_periodic();
+
+    for(int y = 0; y < yres; ++y) {
+        for(int x = 0; x < xres; ++x) {
+            auto& cell = grid.cell(x, y);
+            for(auto it = cell.begin(); it != cell.end(); ++it) {
+                auto& first = (*it).particle();
+                for(auto other = std::next(it); other != cell.end(); ++other) {
+                    m_collision_count += resolve_pair(first, (*other).particle(),
+                            dt, grid);
+                }
+
+                auto reach = first.radius() + grid.displacement(first.position(), 
+                        first.next_position()).magnitude() + partner_reach;
+                auto x_rings = static_cast<int>(std::ceil(reach / grid.dx()));
+                auto y_rings = static_cast<int>(std::ceil(reach / grid.dy()));
+
+                //Only the forward half of the neighborhood, so every pair of
+                //cells is visited once. Periodic neighborhoods wrap around
+                //and reach at most half a period. Offsets of exactly half a
+                //period lead to the same cell from both sides, so they are
+                //only taken from the cell that does not wrap.
+                int x_first, x_last, y_last;
+                if(periodic) {
+                    x_last = std::min(x_rings, xres / 2);
+                    x_first = -std::min(x_rings, (xres - 1) / 2);
+                    y_last = std::min(y_rings, yres / 2);
+                } else {
+                    x_last = std::min(x_rings, xres - 1 - x);
+                    x_first = -std::min(x_rings, x);
+                    y_last = std::min(y_rings, yres - 1 - y);
+                }
+                for(int j = 0; j <= y_last; ++j) {
+                    auto y_other = y + j;
+                    if(y_other >= yres) {
+                        if(j * 2 == yres) break;
+                        y_other -= yres;
+                    }
+                    for(int i = j == 0 ? 1 : x_first; i <= x_last; ++i) {
+                        auto x_other = x + i;
+                        if(x_other < 0 || x_other >= xres) {
+                            if(j == 0 && i * 2 == xres) break;
+                            x_other = (x_other + xres) % xres;
+                        }
+                        for(auto& item : grid.cell(x_other, y_other)) {
+                            m_collision_count += resolve_pair(first,
+                                    item.particle(), dt, grid);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+ 
+bool ParticleCollisionResolver::resolve_pair(Particle& a, Particle& b,
+        PositionType dt, const Grid& grid) const {
+    auto start = grid.displacement(b.position(), a.position());
+    auto step_a = grid.displacement(a.position(), a.next_position());
+    auto step_b = grid.displacement(b.position(), b.next_position());
+    auto motion = step_a - step_b;
+    auto contact_distance = a.radius() + b.radius();
+
+    //Earliest fraction t of the step with |start + motion*t| at contact
+    //distance. Pairs that already overlap are handled at the start.
+    auto qa = motion.magnitude_squared();
+    auto qb = 2 * start.dot(motion);
+    auto qc = start.magnitude_squared() - contact_distance * contact_distance;
+    PositionType t = 0;
+    if(qc > 0) {
+        auto discriminant = qb*qb - 4*qa*qc;
+        if(qa == 0 || discriminant < 0) {
+            return false;
+        }
+        t = (-qb - std::sqrt(discriminant)) / (2*qa);
+        if(t < 0 || t > 1) {
+            return false;
+        }
+    }
+
+    auto normal = start + motion * t;
+    auto distance = normal.magnitude();
+    if(distance == 0) {
+        return false;
+    }
+    normal /= distance;
+
+    auto velocity_a = a.next_velocity();
+    auto velocity_b = b.next_velocity();
+    auto approach_speed = (velocity_a - velocity_b).dot(normal);
+    if(approach_speed >= 0) {
+        return false;
+    }
+
+    auto impulse = -(1 + m_restitution) * approach_speed
+        / (1 / a.mass() + 1 / b.mass());
+    velocity_a += normal * (impulse / a.mass());
+    velocity_b -= normal * (impulse / b.mass());
+
+    //Both continue from the contact point with their new velocities for
+    //the rest of the step. The contact point lies on the segment the
+    //particle already travelled, so it is a safe fallback at the walls.
+    auto remaining = (1 - t) * dt;
+    auto contact_a = a.position() + step_a * t;
+    auto contact_b = b.position() + step_b * t;
+    auto end_position = [&grid](const SpatialVector& contact, 
+            const SpatialVector& position) {
+        if(grid.is_periodic()) {
+            return grid.wrap(position);
+        }
+        return grid.is_point_within(position) ? position : contact;
+    };
+    a.update_position(end_position(contact_a, contact_a + velocity_a * remaining));
+    b.update_position(end_position(contact_b, contact_b + velocity_b * remaining));
+    a.update_velocity(velocity_a);
+    b.update_velocity(velocity_b);
+    //The new velocities can carry both particles well away from where the
+    //integrator evaluated any cached end of step acceleration.
+    a.invalidate_cached_acceleration();
+    b.invalidate_cached_acceleration();
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef PARTICLECOLLISIONRESOLVER_H_
+#define PARTICLECOLLISIONRESOLVER_H_
+
+#include "IParticleCollisionResolver.h"
+#include "CommonTypes.h"
+
+class Particle;
+
+//Treats particles as hard disks of their radius. Candidate pairs come from
+//the grid cells around each particle, wide enough to cover its own radius
+//and step displacement plus the largest ones of any partner, so the broad
+//phase stays linear for uniform densities. Each pair is swept over the step, and the first contact is
+//answered with an impulse along the contact normal.
+class ParticleCollisionResolver: public IParticleCollisionResolver {
+public:
+    ParticleCollisionResolver(PositionType restitution = 1.0);
+    virtual ~ParticleCollisionResolver() = default;
+
+    ParticleCollisionResolver(const ParticleCollisionResolver& other) = delete;
+    ParticleCollisionResolver(ParticleCollisionResolver&& other) noexcept = default;
+    ParticleCollisionResolver& operator =(const ParticleCollisionResolver& other) = delete;
+    ParticleCollisionResolver& operator =(ParticleCollisionResolver&& other) noexcept = default;
+
+    virtual void resolve_particle_collisions(Simulation& simulation, 
+            Grid& grid) override;
+
+    PositionType restitution() const {return m_restitution;}
+    void set_restitution(PositionType value) {m_restitution = value;}
+
+    virtual std::size_t collision_count() const override {
+        return m_collision_count;
+    }
+
+private:
+    bool resolve_pair(Particle& a, Particle& b, PositionType dt, 
+            const Grid& grid) const;
+
+    PositionType m_restitution = 1.0;
+    std::size_t m_collision_count = 0;
+};
+
+#endif
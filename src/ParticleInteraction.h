@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <vector>
+#include <limits>
 
 #include "CommonTypes.h"
 
@@ -19,6 +20,15 @@ public:
 
     virtual std::vector<ChargeIndexType> required_charges() const {return {};}
     virtual void bind_charges(std::vector<ChargeIndexType> charge_indices) = 0;
+
+    //Distance beyond which the interaction exerts no force. Short range
+    //interactions can declare one so solvers only visit nearby cells.
+    virtual PositionType cutoff_radius() const {
+        return std::numeric_limits<PositionType>::infinity();
+    }
+    bool has_cutoff() const {
+        return cutoff_radius() != std::numeric_limits<PositionType>::infinity();
+    }
 };
 
 class ClonableParticleInteraction: public IParticleInteraction {
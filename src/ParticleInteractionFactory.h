@@ -8,7 +8,7 @@
 
 #include "CommonTypes.h"
 
-class IParticleInteraction;
+class InteractionRegistry;
 class Particle;
 
 class IParticleInteractionFactory {
@@ -16,7 +16,10 @@ public:
     IParticleInteractionFactory() = default;
     virtual ~IParticleInteractionFactory() {};
 
-    virtual std::unique_ptr<IParticleInteraction> build_interaction(const Particle& particle) = 0;
+    //Adds the interactions this factory hands out to the registry. Called
+    //once before any particle is assigned a type.
+    virtual void register_interactions(InteractionRegistry& registry) = 0;
+    virtual InteractionTypeId interaction_type(const Particle& particle) const = 0;
 
     virtual std::vector<std::string> required_charge_names() const = 0;
     virtual std::size_t total_charge_count() const = 0;
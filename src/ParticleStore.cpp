@@ -0,0 +1,90 @@
+#include "ParticleStore.h"
+
+#include <algorithm>
+
+void ParticleStore::reserve(std::size_t count) {
+    if(count > m_capacity) {
+        relayout(count, m_num_channels);
+    }
+}
+ 
+void ParticleStore::reserve_charge_channels(std::size_t count) {
+    if(count > m_num_channels) {
+        relayout(m_capacity, count);
+    }
+}
+ 
+std::size_t ParticleStore::push_back() {
+    if(m_size == m_capacity) {
+        relayout(std::max<std::size_t>(1, 2 * m_capacity), m_num_channels);
+    }
+    auto idx = m_size++;
+    for(std::size_t col = 0; col < FIRST_CHARGE + m_num_channels; ++col) {
+        column(col)[idx] = StorageType(0);
+    }
+    return idx;
+}
+ 
+void ParticleStore::pop_back() {
+    assert(m_size > 0);
+    --m_size;
+}
+ 
+void ParticleStore::clear() {
+    m_size = 0;
+    m_num_channels = 0;
+}
+ 
+void ParticleStore::copy_entry(std::size_t idx, const ParticleStore& from,
+        std::size_t from_idx) {
+    assert(idx < m_size && from_idx < from.m_size);
+    auto copied = FIRST_CHARGE + std::min(m_num_channels, from.m_num_channels);
+    for(std::size_t col = 0; col < copied; ++col) {
+        column(col)[idx] = from.column(col)[from_idx];
+    }
+    for(auto col = copied; col < FIRST_CHARGE + m_num_channels; ++col) {
+        column(col)[idx] = StorageType(0);
+    }
+}
+ 
+void ParticleStore::reorder(const std::vector<std::size_t>& order) {
+    assert(order.size() == m_size);
+    std::vector<StorageType> data(m_data.size());
+    for(std::size_t col = 0; col < FIRST_CHARGE + m_num_channels; ++col) {
+        auto source = column(col);
+        auto target = data.data() + col * m_capacity;
+        for(std::size_t k = 0; k < m_size; ++k) {
+            target[k] = source[order[k]];
+        }
+    }
+    m_data.swap(data);
+}
+ 
+void ParticleStore::apply_update() {
+    auto copy_column = [this](std::size_t from, std::size_t to) {
+        std::copy(column(from), column(from) + m_size, column(to));
+    };
+    copy_column(NEXT_X, X);
+    copy_column(NEXT_Y, Y);
+    copy_column(NEXT_VX, VX);
+    copy_column(NEXT_VY, VY);
+    copy_column(AX, LAST_AX);
+    copy_column(AY, LAST_AY);
+}
+ 
+void ParticleStore::apply_velocity_update() {
+    std::copy(column(NEXT_VX), column(NEXT_VX) + m_size, column(VX));
+    std::copy(column(NEXT_VY), column(NEXT_VY) + m_size, column(VY));
+}
+ 
+void ParticleStore::relayout(std::size_t capacity, std::size_t num_channels) {
+    std::vector<StorageType> data((FIRST_CHARGE + num_channels) * capacity,
+            StorageType(0));
+    auto kept = FIRST_CHARGE + std::min(m_num_channels, num_channels);
+    for(std::size_t col = 0; col < kept; ++col) {
+        std::copy(column(col), column(col) + m_size, data.data() + col * capacity);
+    }
+    m_data.swap(data);
+    m_capacity = capacity;
+    m_num_channels = num_channels;
+}
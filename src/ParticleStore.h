@@ -0,0 +1,111 @@
+#ifndef PS_PARTICLE_STORE_H_
+#define PS_PARTICLE_STORE_H_
+
+#include <cassert>
+#include <vector>
+
+#include "CommonTypes.h"
+#include "Vector2.h"
+
+//Structure of arrays holding the physical state of particles. Every
+//quantity, including each charge channel, is a contiguous column, and
+//positions and velocities have a front column read during a frame next to
+//a back column the frame writes. A Grid keeps the state of its particles
+//in one store, entry i belonging to the grid's i-th particle. A Particle
+//refers to its entry and reads and writes through it.
+class ParticleStore {
+public:
+    //The y column of a vector quantity follows its x column.
+    enum Column {
+        X, Y, NEXT_X, NEXT_Y,
+        VX, VY, NEXT_VX, NEXT_VY,
+        AX, AY, LAST_AX, LAST_AY,
+        MASS, RADIUS,
+        //Charge channel c is column FIRST_CHARGE + c.
+        FIRST_CHARGE
+    };
+
+    ParticleStore() = default;
+    ~ParticleStore() = default;
+
+    ParticleStore(const ParticleStore& other) = default;
+    ParticleStore(ParticleStore&& other) noexcept = default;
+    ParticleStore& operator =(const ParticleStore& other) = default;
+    ParticleStore& operator =(ParticleStore&& other) noexcept = default;
+
+    std::size_t size() const {return m_size;}
+    bool empty() const {return m_size == 0;}
+    std::size_t num_charge_channels() const {return m_num_channels;}
+
+    void reserve(std::size_t count);
+    //Adds zeroed channels until there are at least count.
+    void reserve_charge_channels(std::size_t count);
+
+    //Appends an entry with every quantity zero and returns its index.
+    std::size_t push_back();
+    void pop_back();
+    //Removes every entry and channel.
+    void clear();
+
+    //Copies every quantity of entry from_idx of from over entry idx.
+    //Channels this store lacks are dropped and those from lacks are zeroed.
+    void copy_entry(std::size_t idx, const ParticleStore& from,
+            std::size_t from_idx);
+    //Rearranges the entries so that the one at index order[k] moves to
+    //index k.
+    void reorder(const std::vector<std::size_t>& order);
+
+    //Copies the back columns to the front ones and the acceleration to the
+    //last frame's acceleration, for every entry.
+    void apply_update();
+    void apply_velocity_update();
+
+    StorageType* column(std::size_t col) {
+        return m_data.data() + col * m_capacity;
+    }
+    const StorageType* column(std::size_t col) const {
+        return m_data.data() + col * m_capacity;
+    }
+
+    const PositionType* x() const {return column(X);}
+    const PositionType* y() const {return column(Y);}
+    const QuantityType* radius() const {return column(RADIUS);}
+    const ChargeType* charges(std::size_t channel) const {
+        assert(channel < m_num_channels);
+        return column(FIRST_CHARGE + channel);
+    }
+
+    StorageType& value(std::size_t col, std::size_t idx) {
+        assert(idx < m_size);
+        return column(col)[idx];
+    }
+    StorageType value(std::size_t col, std::size_t idx) const {
+        assert(idx < m_size);
+        return column(col)[idx];
+    }
+
+    //Vector quantity whose x column is col_x.
+    SpatialVector vector(std::size_t col_x, std::size_t idx) const {
+        assert(idx < m_size);
+        return SpatialVector(column(col_x)[idx], column(col_x + 1)[idx]);
+    }
+    void set_vector(std::size_t col_x, std::size_t idx,
+            const SpatialVector& value) {
+        assert(idx < m_size);
+        column(col_x)[idx] = value.x;
+        column(col_x + 1)[idx] = value.y;
+    }
+
+private:
+    //Moves the columns into a block with room for capacity entries and
+    //num_channels charge channels.
+    void relayout(std::size_t capacity, std::size_t num_channels);
+
+    //Column c starts at c * m_capacity.
+    std::vector<StorageType> m_data;
+    std::size_t m_size = 0;
+    std::size_t m_capacity = 0;
+    std::size_t m_num_channels = 0;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#include "PeriodicBoundaryResolver.h"
+
+#include <cassert>
+
+#include "Grid.h"
+#include "Simulation.h"
+
+void PeriodicBoundaryResolver::resolve_border_collision(Simulation& simulation, 
+        Grid& grid, Particle& particle, SpatialVector& acceleration) const {
+    //Only reached when called directly, since resolve_step_end always
+    //succeeds.
+    auto position = particle.next_position();
+    auto velocity = particle.next_velocity();
+    simulation.simulate_motion(particle, simulation.simulation_time().time_delta(),
+            acceleration, position, velocity);
+    resolve_step_end(grid, particle, position, velocity);
+    particle.update_position(position);
+    particle.update_velocity(velocity);
+}
+ 
+bool PeriodicBoundaryResolver::resolve_step_end(const Grid& grid, 
+        const Particle& particle, SpatialVector& position, 
+        SpatialVector& velocity) const {
+    assert(grid.is_periodic());
+    position = grid.wrap(position);
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef PERIODICBOUNDARYRESOLVER_H_
+#define PERIODICBOUNDARYRESOLVER_H_
+
+#include "IBoundaryCollisionResolver.h"
+
+//Boundary of a periodic grid. Particles leaving on one side come back in on
+//the opposite one, which only takes wrapping the end of step position.
+class PeriodicBoundaryResolver: public IBoundaryCollisionResolver {
+public:
+    PeriodicBoundaryResolver() = default;
+    virtual ~PeriodicBoundaryResolver() = default;
+
+    PeriodicBoundaryResolver(const PeriodicBoundaryResolver& other) = delete;
+    PeriodicBoundaryResolver(PeriodicBoundaryResolver&& other) noexcept = default;
+    PeriodicBoundaryResolver& operator =(const PeriodicBoundaryResolver& other) = delete;
+    PeriodicBoundaryResolver& operator =(PeriodicBoundaryResolver&& other) noexcept = default;
+
+    virtual void resolve_border_collision(Simulation& simulation, Grid& grid,
+            Particle& particle, SpatialVector& acceleration) const override;
+
+    virtual bool resolve_step_end(const Grid& grid, const Particle& particle,
+            SpatialVector& position, SpatialVector& velocity) const override;
+};
+
+#endif
@@ -57,6 +57,7 @@ public:
     PopulationBuilder&& set_interaction_factory(
             std::unique_ptr<IParticleInteractionFactory> factory) {
         m_interaction_factory = std::move(factory);
+        m_interaction_factory->register_interactions(m_grid->interactions());
         m_charge_dists.clear();
         m_charge_dists.resize(m_interaction_factory->total_charge_count());
         set_charge_defaults();
@@ -98,12 +99,9 @@ public:
 
     PopulationBuilder&& generate(std::size_t num_particles) {
         for(std::size_t n = 0; n < num_particles; ++n) {
-            Particle p(m_radius_dist(m_rng), m_mass_dist(m_rng), 
-                    m_position_dist(m_rng), m_velocity_dist(m_rng),
-                    num_charges());
+            auto p = make_particle(m_radius_dist(m_rng), m_mass_dist(m_rng), 
+                    m_position_dist(m_rng), m_velocity_dist(m_rng));
             if(m_interaction_factory != nullptr) {
-                auto interaction = m_interaction_factory->build_interaction(p);
-                p.set_interaction(std::move(interaction));
                 for(std::size_t i = 0; i < num_charges(); ++i) {
                     p.set_charge(i, m_charge_dists[i](m_rng, p));
                 }
@@ -131,15 +129,26 @@ private:
     void set_defaults(const Grid& grid);
     void set_charge_defaults();
 
+    //The interaction is the grid's shared object for the particle's type.
+    Particle make_particle(QuantityType radius, QuantityType mass,
+            const Vector2<PositionType>& position, 
+            const Vector2<PositionType>& velocity) {
+        Particle p(radius, mass, position, velocity);
+        p.update_charge_count(num_charges());
+        if(m_interaction_factory != nullptr) {
+            auto type = m_interaction_factory->interaction_type(p);
+            p.set_interaction(type, m_grid->interactions().interaction(type));
+        }
+        return p;
+    }
+
     Particle particle_from_params(const ParticleParameters& params) {
         auto mass = params.mass().value_or(m_mass_dist(m_rng));
         auto radius = params.radius().value_or(m_radius_dist(m_rng));
         auto position = params.position().value_or(m_position_dist(m_rng));
         auto velocity = params.velocity().value_or(m_velocity_dist(m_rng));
-        Particle p(radius, mass, position, velocity, num_charges());
+        auto p = make_particle(radius, mass, position, velocity);
         if(m_interaction_factory != nullptr) {
-            auto interaction = m_interaction_factory->build_interaction(p);
-            p.set_interaction(std::move(interaction));
             for(std::size_t i = 0; i < num_charges(); ++i) {
                 if(i < params.charges().size()) {
                     p.set_charge(i, params.charges()[i]
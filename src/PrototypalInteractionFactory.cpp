@@ -1,5 +1,9 @@
 #include "PrototypalInteractionFactory.h"
 
+#include <algorithm>
+
+#include "InteractionRegistry.h"
+
 
 PrototypalInteractionFactory::PrototypalInteractionFactory(
         std::unique_ptr<ClonableParticleInteraction> prototype,
@@ -12,11 +16,11 @@ PrototypalInteractionFactory::PrototypalInteractionFactory(
     } 
 }
  
-std::unique_ptr<IParticleInteraction> PrototypalInteractionFactory::build_interaction(
-        const Particle& particle) {
+void PrototypalInteractionFactory::register_interactions(
+        InteractionRegistry& registry) {
     auto interaction = m_prototype->clone();
     interaction->bind_charges(m_charge_mapping);
-    return m_prototype->clone(); 
+    m_type = registry.add_type(std::move(interaction));
 }
  
 boost::optional<ChargeIndexType> PrototypalInteractionFactory::get_charge_index(
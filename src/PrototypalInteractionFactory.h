@@ -28,8 +28,10 @@ public:
     PrototypalInteractionFactory& operator =(const PrototypalInteractionFactory& other) = delete;
     PrototypalInteractionFactory& operator =(PrototypalInteractionFactory&& other) noexcept = default;
 
-    virtual std::unique_ptr<IParticleInteraction> 
-        build_interaction(const Particle& particle) override;
+    virtual void register_interactions(InteractionRegistry& registry) override;
+    virtual InteractionTypeId interaction_type(const Particle& particle) const override {
+        return m_type;
+    }
 
     const ClonableParticleInteraction* prototype() const {return m_prototype.get();}
 
@@ -46,6 +48,7 @@ private:
     std::unique_ptr<ClonableParticleInteraction> m_prototype;
     std::vector<std::string> m_charge_names;
     std::vector<ChargeIndexType> m_charge_mapping;
+    InteractionTypeId m_type = NO_INTERACTION_TYPE;
 };
 
 #endif
@@ -1,12 +1,23 @@
 #include "Simulation.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cassert>
 
+#include "BlockTimestepScheduler.h"
 #include "BoundaryBounceResolver.h"
 #include "DragPhysicsHandler.h"
 #include "IWorldPhysicsHandler.h"
+#include "IBatchMotionIntegrator.h"
 #include "EulerMotionIntegrator.h"
+#include "ExactForceSolver.h"
+#ifdef NESTING_GRID
+#include "NestingGridForceSolver.h"
+#endif
+#include "PeriodicBoundaryResolver.h"
+#include "SimulationSnapshot.h"
+#include "SynchronousVerletIntegrator.h"
 #include "VelocityVerletIntegrator.h"
+#include "WorkerPool.h"
 
 #ifdef TRACING
 #include "TracerConfig.h"
@@ -21,7 +32,8 @@ Simulation::Simulation(SpatialContainer&& grid, double base_time_step):
 
     m_boundary_collision_resolver = make_default_boundary_resolver();
     m_world_physics = make_default_world_physics();
-    m_integrator = make_default_integrator();
+    set_motion_integrator(make_default_integrator());
+    m_force_solver = make_default_force_solver();
 #ifdef TRACING
     m_tracer = build_tracer();
     setup_tracing();
@@ -34,6 +46,74 @@ Simulation& Simulation::set_boundary_collision_resolver(
     return *this;
 }
  
+Simulation& Simulation::set_periodic(bool value) {
+    m_grid.set_periodic(value);
+    if(value) {
+        m_boundary_collision_resolver = std::make_unique<PeriodicBoundaryResolver>();
+    } else {
+        m_boundary_collision_resolver = make_default_boundary_resolver();
+    }
+    return *this;
+}
+ 
+Simulation& Simulation::set_particle_collision_resolver(
+        std::unique_ptr<IParticleCollisionResolver> resolver) {
+    m_particle_collision_resolver = std::move(resolver);
+    return *this;
+}
+ 
+Simulation& Simulation::set_motion_integrator(
+        std::unique_ptr<IMotionIntegrator> integrator) {
+    m_integrator = std::move(integrator);
+    m_batch_integrator = dynamic_cast<IBatchMotionIntegrator*>(m_integrator.get());
+
+    //Accelerations cached by the previous integrator may not follow the
+    //conventions of the new one.
+    for(auto& item : m_grid) {
+        item.particle().invalidate_cached_acceleration();
+    }
+    return *this;
+}
+ 
+Simulation& Simulation::set_timestep_scheduler(
+        std::unique_ptr<BlockTimestepScheduler> scheduler) {
+    m_timestep_scheduler = std::move(scheduler);
+    for(auto& item : m_grid) {
+        item.particle().set_timestep_level(-1);
+    }
+    return *this;
+}
+ 
+Simulation& Simulation::set_force_solver(std::unique_ptr<IForceSolver> solver) {
+    m_force_solver = std::move(solver);
+    return *this;
+}
+ 
+Simulation& Simulation::set_frame_statistics_sink(
+        std::unique_ptr<IFrameStatisticsSink> sink, std::size_t interval) {
+    assert(interval > 0);
+    m_frame_statistics_sink = std::move(sink);
+    m_frame_statistics_interval = interval;
+    return *this;
+}
+ 
+Simulation& Simulation::set_worker_count(std::size_t count) {
+#ifdef TRACING
+    //The tracer is not thread safe, so traced builds always run serially.
+    count = 1;
+#endif
+    if(count <= 1) {
+        m_worker_pool = nullptr;
+    } else if(worker_count() != count) {
+        m_worker_pool = std::make_unique<WorkerPool>(count);
+    }
+    return *this;
+}
+ 
+std::size_t Simulation::worker_count() const {
+    return m_worker_pool != nullptr ? m_worker_pool->num_workers() : 1;
+}
+ 
 Simulation::~Simulation() {
  
 }
@@ -41,30 +121,260 @@ Simulation::~Simulation() {
 void Simulation::do_frame() {
     m_simulation_time.begin_frame(m_base_time_step);
 
-    std::cout << "===== Frame Start: t=" << m_simulation_time.current_simulation_time()
-        << " =====\n";
+    auto frame_index = m_simulation_time.frame_count() - 1;
+    m_measure_frame = m_frame_statistics_sink != nullptr
+        && frame_index % m_frame_statistics_interval == 0;
+    if(m_measure_frame) {
+        m_force_evaluations = 0;
+        m_wall_collisions = 0;
+        m_particle_collisions = 0;
+    }
 
     SIM_TRACER_EVENT(m_tracer, TraceEventType::FrameBegin, this, m_simulation_time);
 
-    for(int i = 0; i < m_grid.num_cells(); ++i) {
-        auto& cell = m_grid.cell(i);
-        for(auto& item : cell) {
-            auto& particle = item;
+    prepare_forces();
+
+    if(m_batch_integrator != nullptr && m_timestep_scheduler != nullptr) {
+        do_block_frame();
+    } else if(m_batch_integrator != nullptr) {
+        do_batch_frame();
+    } else {
+        //Each particle only reads the front buffers of the others and writes
+        //its own back buffer, so cells can be processed concurrently.
+        auto reuse_acceleration = m_integrator->caches_end_acceleration();
+
+        for_each_particle_by_cell([this, reuse_acceleration](Particle& particle) {
+            auto acceleration = 
+                (reuse_acceleration && particle.has_cached_acceleration())
+                ? particle.current_acceleration()
+                : compute_acceleration(particle);
+            particle.set_acceleration(acceleration);
 
-            auto acceleration = compute_acceleration(particle.particle());
-            particle.particle().set_acceleration(acceleration);
+            advance_physics(particle, m_simulation_time.time_delta(), acceleration);
+        });
 
-            advance_physics(particle.particle(), m_simulation_time.time_delta(), 
-                    acceleration);
+        apply_frame_update();
+    }
+
+    if(m_measure_frame) {
+        report_frame_statistics();
+    }
+
+    SIM_TRACER_EVENT(m_tracer, TraceEventType::FrameEnd, this, m_simulation_time);
+}
+ 
+bool Simulation::save_snapshot(const std::string& path) const {
+    SnapshotWriter writer;
+    writer.write(SNAPSHOT_MAGIC);
+    writer.write(SNAPSHOT_VERSION);
+    writer.write(static_cast<std::uint32_t>(sizeof(PositionType)));
+    writer.write(static_cast<std::uint32_t>(sizeof(ChargeType)));
+
+    writer.write(m_base_time_step);
+    m_simulation_time.write_snapshot(writer);
+    writer.write(Particle::next_id());
+    if(!m_grid.write_snapshot(writer)) {
+        return false;
+    }
+    return writer.save(path);
+}
+ 
+bool Simulation::load_snapshot(const std::string& path) {
+    MappedFile file;
+    if(!file.open(path)) {
+        return false;
+    }
+    SnapshotReader reader(file.data(), file.size());
+    if(reader.read<std::uint32_t>() != SNAPSHOT_MAGIC
+            || reader.read<std::uint32_t>() != SNAPSHOT_VERSION
+            || reader.read<std::uint32_t>() != sizeof(PositionType)
+            || reader.read<std::uint32_t>() != sizeof(ChargeType)) {
+        return false;
+    }
+
+    auto base_time_step = reader.read<double>();
+    auto simulation_time = m_simulation_time;
+    simulation_time.read_snapshot(reader);
+    auto next_id = reader.read<int>();
+    //The grid comes last and only changes if it reads successfully.
+    if(!reader.ok() || !m_grid.read_snapshot(reader)) {
+        return false;
+    }
+
+    m_base_time_step = base_time_step;
+    m_simulation_time = simulation_time;
+    Particle::set_next_id(next_id);
+    return true;
+}
+ 
+void Simulation::do_batch_frame() {
+    auto dt = m_simulation_time.time_delta();
+
+    //Drift every particle with its start of step acceleration. That is the
+    //end of step acceleration of the previous frame, so it only needs to be
+    //evaluated on the first frame.
+    for_each_particle_by_cell([this, dt](Particle& particle) {
+        if(!particle.has_cached_acceleration()) {
+            particle.cache_next_acceleration(compute_acceleration(particle));
         }
+        advance_physics(particle, dt, particle.current_acceleration());
+    });
+
+    apply_frame_update();
+    prepare_forces();
+
+    //All positions are now final, so the end of step forces are consistent.
+    //Kicks go to the back buffer since other particles' forces may read the
+    //front velocity.
+    for_each_particle_by_cell([this, dt](Particle& particle) {
+        auto end_acceleration = compute_acceleration(particle);
+        auto velocity = particle.velocity();
+
+        //Particles sent through the boundary resolver already completed
+        //their step there.
+        if(particle.has_cached_acceleration()) {
+            m_batch_integrator->kick(particle, dt, end_acceleration, velocity);
+        }
+        particle.update_velocity(velocity);
+        particle.cache_next_acceleration(end_acceleration);
+    });
+
+    m_grid.particle_store().apply_velocity_update();
+}
+ 
+void Simulation::do_block_frame() {
+    auto& scheduler = *m_timestep_scheduler;
+    auto base_dt = m_base_time_step;
+    auto substep_dt = base_dt / scheduler.substeps();
+
+    scheduler.begin_frame();
+
+    std::size_t substep = 0;
+    while(substep < scheduler.substeps()) {
+        //Nothing happens until the next boundary of the finest level in use.
+        int finest_level = 0;
+        for(auto& item : m_grid) {
+            finest_level = std::max(finest_level, 
+                    scheduler.level_of(item.particle()));
+        }
+        auto stride = scheduler.stride(finest_level);
+        auto end = substep + stride;
+        auto dt = stride * substep_dt;
+
+        m_simulation_time.begin_substep(dt, scheduler.boundary_level(end));
+
+        //Opening half kick for particles starting a step. Written to the
+        //back buffer, which the drift starts from.
+        for_each_particle_by_cell([&](Particle& particle) {
+            if(!scheduler.is_step_boundary(particle, substep)) return;
+            if(!particle.has_cached_acceleration()) {
+                particle.cache_next_acceleration(compute_acceleration(particle));
+            }
+            if(particle.timestep_level() < 0) {
+                particle.set_timestep_level(scheduler.max_level());
+            }
+            auto velocity = particle.next_velocity();
+            m_batch_integrator->kick(particle, 
+                    scheduler.time_step(particle.timestep_level(), base_dt), 
+                    particle.current_acceleration(), velocity);
+            particle.update_velocity(velocity);
+        });
+
+        //Every particle drifts so that forces always see current positions;
+        //the accelerations were already applied by the kicks.
+        for_each_particle_by_cell([this, dt](Particle& particle) {
+            advance_physics(particle, dt, SpatialVector::zero());
+        });
+
+        apply_frame_update();
+        prepare_forces();
+
+        std::size_t active = 0;
+        for(auto& item : m_grid) {
+            if(scheduler.is_step_boundary(item.particle(), end)) {
+                ++active;
+            }
+        }
+        scheduler.record_substep(active, m_grid.num_particles(), finest_level);
+
+        //Closing half kick and new level for particles ending a step.
+        //Particles inserted during this sub-step had no opening kick and
+        //only get their acceleration and level.
+        for_each_particle_by_cell([&](Particle& particle) {
+            if(!scheduler.is_step_boundary(particle, end)) return;
+            auto end_acceleration = compute_acceleration(particle);
+            auto velocity = particle.velocity();
+            if(particle.timestep_level() >= 0) {
+                m_batch_integrator->kick(particle, 
+                        scheduler.time_step(particle.timestep_level(), base_dt),
+                        end_acceleration, velocity);
+            }
+            particle.update_velocity(velocity);
+            particle.cache_next_acceleration(end_acceleration);
+            scheduler.assign_level(particle, end, base_dt);
+        });
+
+        m_grid.particle_store().apply_velocity_update();
+        substep = end;
     }
 
+    scheduler.end_frame();
+}
+ 
+void Simulation::apply_frame_update() {
+    //Every particle has moved but the cells still match the start of the
+    //step, which is what the collision broad phase expects.
+    if(m_particle_collision_resolver != nullptr) {
+        m_particle_collision_resolver->resolve_particle_collisions(*this, m_grid);
+        if(m_measure_frame) {
+            m_particle_collisions += m_particle_collision_resolver->collision_count();
+        }
+    }
     m_grid.next_frame();
-    for(auto& particle : m_grid) {
-        m_grid.update_particle(*particle.second);
+    m_grid.update_cells(m_worker_pool.get());
+}
+ 
+void Simulation::prepare_forces() {
+#ifdef NESTING_GRID
+    m_grid.refresh_layers();
+#endif
+    m_force_solver->prepare_frame(*this, m_grid);
+}
+ 
+void Simulation::report_frame_statistics() {
+    FrameStatistics statistics;
+    statistics.frame_index = m_simulation_time.frame_count() - 1;
+    statistics.simulation_time = m_simulation_time.current_simulation_time();
+    statistics.time_step = m_base_time_step;
+    statistics.wall_time = std::chrono::duration_cast<SimulationTime::ClockDuration>(
+            SimulationTime::Clock::now() - m_simulation_time.current_clock_time())
+        .count();
+    statistics.particle_count = m_grid.num_particles();
+    statistics.force_evaluations = m_force_evaluations;
+    statistics.wall_collisions = m_wall_collisions;
+    statistics.particle_collisions = m_particle_collisions;
+    m_frame_statistics_sink->on_frame(statistics);
+}
+ 
+void Simulation::for_each_particle_by_cell(
+        const std::function<void (Particle&)>& fn) {
+    if(m_worker_pool == nullptr) {
+        for(std::size_t i = 0; i < m_grid.num_cells(); ++i) {
+            for(auto& item : m_grid.cell(i)) {
+                fn(item.particle());
+            }
+        }
+        return;
     }
 
-    SIM_TRACER_EVENT(m_tracer, TraceEventType::FrameEnd, this, m_simulation_time);
+    m_worker_pool->parallel_for(m_grid.num_cells(), 
+        [this, &fn](std::size_t begin, std::size_t end, std::size_t) {
+            for(auto i = begin; i < end; ++i) {
+                for(auto& item : m_grid.cell(i)) {
+                    fn(item.particle());
+                }
+            }
+        });
 }
  
 void Simulation::simulate_motion(Particle& particle, 
@@ -93,7 +403,15 @@ std::unique_ptr<IWorldPhysicsHandler> Simulation::make_default_world_physics() {
 }
  
 std::unique_ptr<IMotionIntegrator> Simulation::make_default_integrator() {
-    return std::make_unique<VelocityVerletIntegrator>(); 
+    return std::make_unique<SynchronousVerletIntegrator>(); 
+}
+ 
+std::unique_ptr<IForceSolver> Simulation::make_default_force_solver() {
+#ifdef NESTING_GRID
+    return std::make_unique<NestingGridForceSolver>(m_grid);
+#else
+    return std::make_unique<ExactForceSolver>();
+#endif
 }
  
 ForceType Simulation::compute_acceleration(Particle& particle) {
@@ -104,7 +422,11 @@ ForceType Simulation::compute_acceleration(Particle& particle) {
 ForceType Simulation::compute_acceleration(Particle& particle, 
     const SpatialVector& updated_position, const SpatialVector& updated_velocity) {
          
-    auto force = compute_exact_force(particle, updated_position, updated_velocity);
+    if(m_measure_frame) {
+        m_force_evaluations.fetch_add(1, std::memory_order_relaxed);
+    }
+    auto force = compute_interaction_force(particle, updated_position, 
+            updated_velocity);
 
     if(m_world_physics != nullptr) {
         auto world_force = 
@@ -121,25 +443,24 @@ void Simulation::on_particle_out_of_boundry(Particle& particle,
         SpatialVector& acceleration) {
     PARTICLE_TRACER_EVENT(m_tracer, TraceEventType::WallCollideBegin, particle,
             this, m_simulation_time);
+    if(m_measure_frame) {
+        m_wall_collisions.fetch_add(1, std::memory_order_relaxed);
+    }
 
     m_boundary_collision_resolver->resolve_border_collision(*this, m_grid,
             particle, acceleration);
+    //The resolver runs partial steps, so whatever the integrator cached no
+    //longer matches the particle's final state.
+    particle.invalidate_cached_acceleration();
 
     PARTICLE_TRACER_EVENT(m_tracer, TraceEventType::WallCollideEnd, particle,
             this, m_simulation_time);
 }
 
-ForceType Simulation::compute_exact_force(const Particle& particle,
+ForceType Simulation::compute_interaction_force(const Particle& particle,
         const SpatialVector& position, const SpatialVector& velocity) {
-    auto force = ForceType::zero();
-
-    for(auto& item : m_grid) {
-        auto& target = *item.second;
-        if(&target.particle() == &particle) continue;
-        force += particle.compute_force(target.particle(), position, velocity);
-    } 
-
-    return force;
+    return m_force_solver->compute_force(particle, position, velocity, 
+            *this, m_grid);
 }
  
 ForceType Simulation::compute_acceleration_from_force(const Particle& particle, 
@@ -154,9 +475,18 @@ void Simulation::advance_physics(Particle& particle, double dt, SpatialVector ac
     auto new_position = particle.next_position();
     auto new_velocity = particle.next_velocity();
 
-    simulate_motion(particle, dt, acceleration, new_position, new_velocity);
+    //Batch integrators only drift here; the kick follows once every particle
+    //has moved.
+    if(m_batch_integrator != nullptr) {
+        m_batch_integrator->drift(particle, dt, acceleration, new_position, 
+                new_velocity);
+    } else {
+        simulate_motion(particle, dt, acceleration, new_position, new_velocity);
+    }
 
-    if(!m_grid.is_point_within(new_position)) {
+    if(!m_grid.is_point_within(new_position) 
+            && !m_boundary_collision_resolver->resolve_step_end(m_grid, 
+                particle, new_position, new_velocity)) {
         //If we detect a boundary collision, we discard the simulation and
         //run a more detailed simulation that breaks the movement up into segments
         //between each collision.
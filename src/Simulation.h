@@ -1,20 +1,36 @@
 #ifndef PS_SIMULATION_H_
 #define PS_SIMULATION_H_
 
+#include <atomic>
 #include <memory>
+#include <functional>
+#include <string>
 
 #include "Grid.h"
+#ifdef NESTING_GRID
+#include "NestingGrid.h"
+#endif
 #include "SimulationTime.h"
 #include "IBoundaryCollisionResolver.h"
+#include "IParticleCollisionResolver.h"
+#include "IForceSolver.h"
+#include "IFrameStatisticsSink.h"
 
 #include "tracing/Tracer.h"
 
 class IWorldPhysicsHandler;
 class IMotionIntegrator;
+class BlockTimestepScheduler;
+class IBatchMotionIntegrator;
+class WorkerPool;
 
 class Simulation {
 public:
+#ifdef NESTING_GRID
+    using SpatialContainer = NestingGrid;
+#else
     using SpatialContainer = Grid;
+#endif
 
     Simulation(SpatialContainer&& grid,
             double base_time_step = 1.0);
@@ -31,8 +47,59 @@ public:
         return *m_boundary_collision_resolver;
     }
 
+    //Switches the grid between walls and periodic wrap-around, installing
+    //the matching boundary resolver.
+    Simulation& set_periodic(bool value);
+    bool is_periodic() const {return m_grid.is_periodic();}
+
+    //Particle-particle collisions are not resolved unless a resolver is set.
+    Simulation& set_particle_collision_resolver(
+            std::unique_ptr<IParticleCollisionResolver> resolver);
+    IParticleCollisionResolver* particle_collision_resolver() {
+        return m_particle_collision_resolver.get();
+    }
+
+    Simulation& set_motion_integrator(std::unique_ptr<IMotionIntegrator> integrator);
+    IMotionIntegrator& motion_integrator() {
+        return *m_integrator;
+    }
+
+    //Enables per particle block time steps, or disables them when null.
+    //Only used with an IBatchMotionIntegrator.
+    Simulation& set_timestep_scheduler(
+            std::unique_ptr<BlockTimestepScheduler> scheduler);
+    BlockTimestepScheduler* timestep_scheduler() {
+        return m_timestep_scheduler.get();
+    }
+
+    Simulation& set_force_solver(std::unique_ptr<IForceSolver> solver);
+    IForceSolver& force_solver() {
+        return *m_force_solver;
+    }
+
+    //Number of threads used for the force and integration phase of a frame.
+    //A count of 1 runs the frame serially on the calling thread.
+    Simulation& set_worker_count(std::size_t count);
+    std::size_t worker_count() const;
+
+    //Reports every interval-th frame to the sink. Frames are neither
+    //measured nor reported while no sink is set, which is the default.
+    Simulation& set_frame_statistics_sink(
+            std::unique_ptr<IFrameStatisticsSink> sink, std::size_t interval = 1);
+    IFrameStatisticsSink* frame_statistics_sink() {
+        return m_frame_statistics_sink.get();
+    }
+
     void do_frame();
 
+    //Writes the particles, grid state, time and particle id counter to a
+    //binary snapshot between frames. Loading it into a simulation set up
+    //with the same grid shape, interaction types, solver and integrator
+    //continues the exact trajectory. Loading leaves the simulation as it
+    //was if the snapshot cannot be used.
+    bool save_snapshot(const std::string& path) const;
+    bool load_snapshot(const std::string& path);
+
     double base_time_step() const {return m_base_time_step;}
     void set_base_time_step(double value) {m_base_time_step = value;}
 
@@ -66,10 +133,20 @@ private:
     std::unique_ptr<IBoundaryCollisionResolver> make_default_boundary_resolver();
     std::unique_ptr<IWorldPhysicsHandler> make_default_world_physics();
     std::unique_ptr<IMotionIntegrator> make_default_integrator();
+    std::unique_ptr<IForceSolver> make_default_force_solver();
+
+    void do_batch_frame();
+    void do_block_frame();
+    void apply_frame_update();
+    //Brings everything the force solver reads up to date with the current
+    //positions, then lets the solver prepare.
+    void prepare_forces();
+    void report_frame_statistics();
+    void for_each_particle_by_cell(const std::function<void (Particle&)>& fn);
 
     void on_particle_out_of_boundry(Particle& particle, SpatialVector& acceleration);
 
-    ForceType compute_exact_force(const Particle& particle, 
+    ForceType compute_interaction_force(const Particle& particle, 
             const SpatialVector& updated_position, const SpatialVector& updated_velocity);
     ForceType compute_acceleration_from_force(const Particle& particle, 
             const ForceType& force) const;
@@ -79,8 +156,21 @@ private:
             SpatialVector& position, SpatialVector& velocity);
 
     std::unique_ptr<IBoundaryCollisionResolver> m_boundary_collision_resolver;
+    std::unique_ptr<IParticleCollisionResolver> m_particle_collision_resolver;
     std::unique_ptr<IWorldPhysicsHandler> m_world_physics;
     std::unique_ptr<IMotionIntegrator> m_integrator;
+    IBatchMotionIntegrator* m_batch_integrator = nullptr;
+    std::unique_ptr<BlockTimestepScheduler> m_timestep_scheduler;
+    std::unique_ptr<IForceSolver> m_force_solver;
+    std::unique_ptr<WorkerPool> m_worker_pool;
+    std::unique_ptr<IFrameStatisticsSink> m_frame_statistics_sink;
+    std::size_t m_frame_statistics_interval = 1;
+
+    //Counters of the frame being measured. Workers update them concurrently.
+    bool m_measure_frame = false;
+    std::atomic<std::size_t> m_force_evaluations{0};
+    std::atomic<std::size_t> m_wall_collisions{0};
+    std::size_t m_particle_collisions = 0;
 
     SpatialContainer m_grid;        
     SimulationTime m_simulation_time;
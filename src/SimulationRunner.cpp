@@ -1,5 +1,6 @@
 #include "SimulationRunner.h"
 
+#include <cstdio>
 #include <thread>
 
 #include "Simulation.h"
@@ -33,6 +34,23 @@ SimulationRunner& SimulationRunner::set_stopping_condition(std::nullptr_t) {
     return *this; 
 }
  
+SimulationRunner& SimulationRunner::set_checkpoint(std::string path, 
+        std::size_t interval) {
+    m_checkpoint_path = std::move(path);
+    m_checkpoint_interval = interval;
+    return *this;
+}
+ 
+bool SimulationRunner::write_checkpoint() {
+    auto temporary_path = m_checkpoint_path + ".tmp";
+    return m_simulation->save_snapshot(temporary_path)
+        && std::rename(temporary_path.c_str(), m_checkpoint_path.c_str()) == 0;
+}
+ 
+bool SimulationRunner::restore_checkpoint(const std::string& path) {
+    return m_simulation->load_snapshot(path);
+}
+ 
 void SimulationRunner::run() {
     m_is_running = true;
     while(m_is_running) {
@@ -61,5 +79,10 @@ void SimulationRunner::pause() {
  
 void SimulationRunner::execute_frame() {
     m_simulation->do_frame();
+    if(m_checkpoint_interval > 0 && m_simulation->simulation_time().frame_count() 
+            % m_checkpoint_interval == 0 && !write_checkpoint()) {
+        m_failed_checkpoints += 1;
+        m_on_checkpoint_failed_event(*m_simulation, *this);
+    }
 }
  
@@ -5,6 +5,7 @@
 #include <limits>
 #include <functional>
 #include <chrono>
+#include <string>
 
 #include "SimulationTime.h"
 #include "Event.h"
@@ -51,6 +52,23 @@ public:
         return m_on_frame_end_event.register_handler(std::move(fn));
     }
 
+    //Saves a snapshot to path after every interval-th frame of the
+    //simulation, replacing the previous one. 0 disables checkpoints.
+    SimulationRunner& set_checkpoint(std::string path, std::size_t interval);
+    const std::string& checkpoint_path() const {return m_checkpoint_path;}
+    std::size_t checkpoint_interval() const {return m_checkpoint_interval;}
+    //The snapshot is written next to the checkpoint and renamed over it,
+    //so a crash while writing keeps the previous checkpoint.
+    bool write_checkpoint();
+    //Continues from a checkpoint or any other snapshot.
+    bool restore_checkpoint(const std::string& path);
+    //Raised when a periodic checkpoint could not be written. The previous
+    //checkpoint, if any, is left in place.
+    EventConnection on_checkpoint_failed(FrameEventFn fn) {
+        return m_on_checkpoint_failed_event.register_handler(std::move(fn));
+    }
+    std::size_t failed_checkpoints() const {return m_failed_checkpoints;}
+
     void run();
     void step();
     void pause();
@@ -62,10 +80,14 @@ private:
     StoppingFn m_stopping_condition;
     FrameEvent m_on_frame_start_event;
     FrameEvent m_on_frame_end_event;
+    FrameEvent m_on_checkpoint_failed_event;
 
     std::chrono::duration<double, std::ratio<1, 1>> m_delay 
         = std::chrono::duration<double, std::ratio<1, 1>>(0.0);
     double m_stop_time = std::numeric_limits<double>::max();
+    std::string m_checkpoint_path;
+    std::size_t m_checkpoint_interval = 0;
+    std::size_t m_failed_checkpoints = 0;
     bool m_is_running = false;
 };
 
@@ -0,0 +1,109 @@
+#include "SimulationSnapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PS_SNAPSHOT_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+void SnapshotWriter::write_bytes(const void* data, std::size_t size) {
+    auto bytes = static_cast<const char*>(data);
+    m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+}
+ 
+bool SnapshotWriter::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(m_buffer.data(), m_buffer.size());
+    file.close();
+    return !file.fail();
+}
+ 
+SnapshotReader::SnapshotReader(const char* data, std::size_t size):
+    m_data(data), m_size(size) {}
+ 
+void SnapshotReader::read_bytes(void* data, std::size_t size) {
+    if(!m_ok || size > remaining()) {
+        m_ok = false;
+        std::memset(data, 0, size);
+        return;
+    }
+    std::memcpy(data, m_data + m_offset, size);
+    m_offset += size;
+}
+ 
+void SnapshotReader::seek(std::size_t offset) {
+    if(offset > m_size) {
+        m_ok = false;
+        return;
+    }
+    m_offset = offset;
+}
+ 
+bool SnapshotReader::expect(std::size_t count, std::size_t item_size) {
+    if(item_size != 0 && count > remaining() / item_size) {
+        m_ok = false;
+    }
+    return m_ok;
+}
+ 
+MappedFile::~MappedFile() {
+    close();
+}
+ 
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef PS_SNAPSHOT_MMAP
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if(::fstat(fd, &status) != 0) {
+        ::close(fd);
+        return false;
+    }
+    m_size = static_cast<std::size_t>(status.st_size);
+    if(m_size > 0) {
+        auto address = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(address == MAP_FAILED) {
+            ::close(fd);
+            m_size = 0;
+            return false;
+        }
+        m_data = static_cast<const char*>(address);
+        m_mapped = true;
+    }
+    //The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+    return true;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if(!file) {
+        return false;
+    }
+    m_contents.assign(std::istreambuf_iterator<char>(file), 
+            std::istreambuf_iterator<char>());
+    m_data = m_contents.data();
+    m_size = m_contents.size();
+    return true;
+#endif
+}
+ 
+void MappedFile::close() {
+#ifdef PS_SNAPSHOT_MMAP
+    if(m_mapped) {
+        ::munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    m_mapped = false;
+    m_contents.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,115 @@
+#ifndef PS_SIMULATION_SNAPSHOT_H_
+#define PS_SIMULATION_SNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//Binary snapshots of a simulation's state. Values are stored in the native
+//byte order and precision, and the header rejects builds that differ in
+//either. Interactions are code rather than data, so particles only store
+//their InteractionRegistry type and a snapshot must be loaded into a
+//simulation that registered the same types in the same order.
+constexpr std::uint32_t SNAPSHOT_MAGIC = 0x50534e50;
+constexpr std::uint32_t SNAPSHOT_VERSION = 1;
+
+class SnapshotWriter {
+public:
+    SnapshotWriter() = default;
+    ~SnapshotWriter() = default;
+
+    SnapshotWriter(const SnapshotWriter& other) = delete;
+    SnapshotWriter(SnapshotWriter&& other) noexcept = default;
+    SnapshotWriter& operator =(const SnapshotWriter& other) = delete;
+    SnapshotWriter& operator =(SnapshotWriter&& other) noexcept = default;
+
+    template<typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, 
+                "Snapshot values must be trivially copyable");
+        write_bytes(&value, sizeof(T));
+    }
+    void write_bytes(const void* data, std::size_t size);
+
+    const std::vector<char>& buffer() const {return m_buffer;}
+    //Empties the buffer but keeps its memory for reuse.
+    void clear() {m_buffer.clear();}
+
+    //Writes the whole buffer to a file in a single write.
+    bool save(const std::string& path) const;
+
+private:
+    std::vector<char> m_buffer;
+};
+
+//Reads values back in the order they were written. Reading past the end
+//fails the reader and yields zeroes, so a whole section can be read before
+//checking ok().
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, std::size_t size);
+    ~SnapshotReader() = default;
+
+    SnapshotReader(const SnapshotReader& other) = delete;
+    SnapshotReader(SnapshotReader&& other) noexcept = default;
+    SnapshotReader& operator =(const SnapshotReader& other) = delete;
+    SnapshotReader& operator =(SnapshotReader&& other) noexcept = default;
+
+    template<typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable<T>::value, 
+                "Snapshot values must be trivially copyable");
+        T value{};
+        read_bytes(&value, sizeof(T));
+        return value;
+    }
+    void read_bytes(void* data, std::size_t size);
+
+    //Fails the reader unless count items of item_size bytes remain, which
+    //guards allocations sized by counts read from the snapshot.
+    bool expect(std::size_t count, std::size_t item_size);
+
+    std::size_t offset() const {return m_offset;}
+    //Continues reading at an absolute offset, failing beyond the end.
+    void seek(std::size_t offset);
+
+    bool ok() const {return m_ok;}
+    void fail() {m_ok = false;}
+    std::size_t remaining() const {return m_size - m_offset;}
+
+private:
+    const char* m_data;
+    std::size_t m_size;
+    std::size_t m_offset = 0;
+    bool m_ok = true;
+};
+
+//Read only contents of a whole file, memory mapped where the platform
+//supports it.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile(MappedFile&& other) noexcept = delete;
+    MappedFile& operator =(const MappedFile& other) = delete;
+    MappedFile& operator =(MappedFile&& other) noexcept = delete;
+
+    bool open(const std::string& path);
+
+    const char* data() const {return m_data;}
+    std::size_t size() const {return m_size;}
+
+private:
+    void close();
+
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_mapped = false;
+    std::vector<char> m_contents;
+};
+
+#endif
@@ -1,15 +1,41 @@
 #include "SimulationTime.h"
 
+#include "SimulationSnapshot.h"
+
 
 SimulationTime::SimulationTime() {
 }
  
 void SimulationTime::begin_frame(TimeType timestep) {
+    ++m_frame_count;
     m_prev_clock_time = m_cur_clock_time;
     m_cur_clock_time = Clock::now();
     
     m_prev_frame_time = m_cur_frame_time;
     m_cur_frame_time += timestep;
     m_dt = timestep;
+    m_active_level = 0;
 }
  
+void SimulationTime::begin_substep(TimeType timestep, int active_level) {
+    m_dt = timestep;
+    m_active_level = active_level;
+}
+ 
+void SimulationTime::write_snapshot(SnapshotWriter& writer) const {
+    writer.write(m_prev_frame_time);
+    writer.write(m_cur_frame_time);
+    writer.write(m_dt);
+    writer.write(m_active_level);
+    writer.write(static_cast<std::uint64_t>(m_frame_count));
+}
+ 
+void SimulationTime::read_snapshot(SnapshotReader& reader) {
+    m_prev_frame_time = reader.read<TimeType>();
+    m_cur_frame_time = reader.read<TimeType>();
+    m_dt = reader.read<TimeType>();
+    m_active_level = reader.read<int>();
+    m_frame_count = static_cast<std::size_t>(reader.read<std::uint64_t>());
+    m_cur_clock_time = Clock::now();
+    m_prev_clock_time = m_cur_clock_time;
+}
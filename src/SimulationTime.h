@@ -2,6 +2,10 @@
 #define PS_SIMULATION_TIME_H_
 
 #include <chrono>
+#include <cstddef>
+
+class SnapshotWriter;
+class SnapshotReader;
 
 class SimulationTime {
 public:
@@ -19,6 +23,9 @@ public:
     SimulationTime& operator =(SimulationTime&& other) noexcept = default;
 
     void begin_frame(TimeType timestep);
+    //Narrows the frame to one block timestep sub-step. time_delta() reports
+    //the sub-step length until the next frame begins.
+    void begin_substep(TimeType timestep, int active_level);
 
     ClockTimePoint previous_clock_time() const {return m_prev_clock_time;}
     ClockTimePoint current_clock_time() const {return m_cur_clock_time;}
@@ -27,9 +34,19 @@ public:
                 m_cur_clock_time - m_prev_clock_time);
     }
 
+    //Frames begun so far, including the current one.
+    std::size_t frame_count() const {return m_frame_count;}
+
     TimeType previous_simulation_time() const {return m_prev_frame_time;}
     TimeType current_simulation_time() const {return m_cur_frame_time;}
     TimeType time_delta() const {return m_dt;}
+    //Coarsest block timestep level completing a step in the current
+    //sub-step. 0 outside of block timestepping.
+    int active_level() const {return m_active_level;}
+
+    //Simulation time and frame count. The clock restarts on reading.
+    void write_snapshot(SnapshotWriter& writer) const;
+    void read_snapshot(SnapshotReader& reader);
 
 private:    
     ClockTimePoint m_prev_clock_time;
@@ -38,6 +55,8 @@ private:
     TimeType m_prev_frame_time = 0.0;
     TimeType m_cur_frame_time = 0.0;
     TimeType m_dt = 0.0;
+    int m_active_level = 0;
+    std::size_t m_frame_count = 0;
 };
 
 #endif
@@ -0,0 +1,192 @@
+#ifndef PS_SLOTMAP_H_
+#define PS_SLOTMAP_H_
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+//Generational slot map. Values live contiguously in insertion order and are
+//removed by swapping the last value into the hole, so any removal moves at
+//most one other value. Handles stay valid across those moves and go stale
+//once their value is erased, even if the slot is reused.
+template<typename T>
+class SlotMap {
+public:
+    using ValueContainer = std::vector<T>;
+    using iterator = typename ValueContainer::iterator;
+    using const_iterator = typename ValueContainer::const_iterator;
+
+    struct Handle {
+        std::uint32_t slot = INVALID_INDEX;
+        std::uint32_t generation = 0;
+
+        bool operator ==(const Handle& rhs) const {
+            return slot == rhs.slot && generation == rhs.generation;
+        }
+        bool operator !=(const Handle& rhs) const {
+            return !(*this == rhs);
+        }
+    };
+
+    SlotMap() = default;
+    ~SlotMap() = default;
+
+    SlotMap(const SlotMap& other) = delete;
+    SlotMap(SlotMap&& other) noexcept = default;
+    SlotMap& operator =(const SlotMap& other) = delete;
+    SlotMap& operator =(SlotMap&& other) noexcept = default;
+
+    iterator begin() {return m_values.begin();}
+    iterator end() {return m_values.end();}
+    const_iterator begin() const {return m_values.begin();}
+    const_iterator end() const {return m_values.end();}
+
+    std::size_t size() const {return m_values.size();}
+    bool empty() const {return m_values.empty();}
+    void reserve(std::size_t count);
+
+    Handle insert(T&& value);
+    bool erase(Handle handle);
+    void clear();
+    //Rearranges the values so that the one at index order[k] moves to index
+    //k. Handles stay valid.
+    void reorder(const std::vector<std::size_t>& order);
+
+    bool contains(Handle handle) const;
+
+    T& operator [](Handle handle) {
+        assert(contains(handle));
+        return m_values[m_slots[handle.slot].index];
+    }
+    const T& operator [](Handle handle) const {
+        assert(contains(handle));
+        return m_values[m_slots[handle.slot].index];
+    }
+
+    //Position of a value in the dense array, which changes when other
+    //values are erased.
+    std::size_t index_of(Handle handle) const {
+        assert(contains(handle));
+        return m_slots[handle.slot].index;
+    }
+    Handle handle_at(std::size_t index) const {
+        assert(index < m_values.size());
+        auto slot = m_slot_of_index[index];
+        return Handle{slot, m_slots[slot].generation};
+    }
+
+    T& value_at(std::size_t index) {
+        assert(index < m_values.size());
+        return m_values[index];
+    }
+    const T& value_at(std::size_t index) const {
+        assert(index < m_values.size());
+        return m_values[index];
+    }
+
+private:
+    static constexpr std::uint32_t INVALID_INDEX =
+        std::numeric_limits<std::uint32_t>::max();
+
+    //A live slot holds the index of its value. A free slot holds the next
+    //free slot instead.
+    struct Slot {
+        std::uint32_t index;
+        std::uint32_t generation;
+    };
+
+    ValueContainer m_values;
+    std::vector<std::uint32_t> m_slot_of_index;
+    std::vector<Slot> m_slots;
+    std::uint32_t m_free_head = INVALID_INDEX;
+};
+
+template<typename T>
+inline void SlotMap<T>::reserve(std::size_t count) {
+    m_values.reserve(count);
+    m_slot_of_index.reserve(count);
+    m_slots.reserve(count);
+}
+
+template<typename T>
+inline typename SlotMap<T>::Handle SlotMap<T>::insert(T&& value) {
+    auto index = static_cast<std::uint32_t>(m_values.size());
+    std::uint32_t slot;
+    if(m_free_head != INVALID_INDEX) {
+        slot = m_free_head;
+        m_free_head = m_slots[slot].index;
+        m_slots[slot].index = index;
+    } else {
+        slot = static_cast<std::uint32_t>(m_slots.size());
+        m_slots.push_back(Slot{index, 0});
+    }
+
+    m_values.push_back(std::move(value));
+    m_slot_of_index.push_back(slot);
+    return Handle{slot, m_slots[slot].generation};
+}
+
+template<typename T>
+inline bool SlotMap<T>::erase(Handle handle) {
+    if(!contains(handle)) {
+        return false;
+    }
+
+    auto index = m_slots[handle.slot].index;
+    auto last = m_values.size() - 1;
+    if(index != last) {
+        m_values[index] = std::move(m_values[last]);
+        m_slot_of_index[index] = m_slot_of_index[last];
+        m_slots[m_slot_of_index[index]].index = index;
+    }
+    m_values.pop_back();
+    m_slot_of_index.pop_back();
+
+    auto& slot = m_slots[handle.slot];
+    slot.generation += 1;
+    slot.index = m_free_head;
+    m_free_head = handle.slot;
+    return true;
+}
+
+template<typename T>
+inline void SlotMap<T>::clear() {
+    for(std::uint32_t i = 0; i < m_slot_of_index.size(); ++i) {
+        auto slot = m_slot_of_index[i];
+        m_slots[slot].generation += 1;
+        m_slots[slot].index = m_free_head;
+        m_free_head = slot;
+    }
+    m_values.clear();
+    m_slot_of_index.clear();
+}
+
+template<typename T>
+inline void SlotMap<T>::reorder(const std::vector<std::size_t>& order) {
+    assert(order.size() == m_values.size());
+    ValueContainer values;
+    std::vector<std::uint32_t> slot_of_index;
+    values.reserve(order.size());
+    slot_of_index.reserve(order.size());
+    for(auto index : order) {
+        values.push_back(std::move(m_values[index]));
+        slot_of_index.push_back(m_slot_of_index[index]);
+    }
+    for(std::uint32_t i = 0; i < slot_of_index.size(); ++i) {
+        m_slots[slot_of_index[i]].index = i;
+    }
+    m_values.swap(values);
+    m_slot_of_index.swap(slot_of_index);
+}
+
+template<typename T>
+inline bool SlotMap<T>::contains(Handle handle) const {
+    return handle.slot < m_slots.size()
+        && m_slots[handle.slot].generation == handle.generation
+        && m_slots[handle.slot].index < m_values.size()
+        && m_slot_of_index[m_slots[handle.slot].index] == handle.slot;
+}
+
+#endif
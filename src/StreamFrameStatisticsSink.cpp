@@ -0,0 +1,15 @@
+#include "StreamFrameStatisticsSink.h"
+
+StreamFrameStatisticsSink::StreamFrameStatisticsSink(std::ostream& stream):
+    m_stream(stream) {}
+ 
+void StreamFrameStatisticsSink::on_frame(const FrameStatistics& statistics) {
+    m_stream << "frame " << statistics.frame_index 
+        << " t=" << statistics.simulation_time
+        << " dt=" << statistics.time_step
+        << " wall=" << statistics.wall_time << "s"
+        << " particles=" << statistics.particle_count
+        << " force_evaluations=" << statistics.force_evaluations
+        << " wall_collisions=" << statistics.wall_collisions
+        << " particle_collisions=" << statistics.particle_collisions << '\n';
+}
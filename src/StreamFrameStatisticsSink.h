@@ -0,0 +1,25 @@
+#ifndef STREAMFRAMESTATISTICSSINK_H_
+#define STREAMFRAMESTATISTICSSINK_H_
+
+#include <ostream>
+
+#include "IFrameStatisticsSink.h"
+
+//Writes one line per reported frame.
+class StreamFrameStatisticsSink: public IFrameStatisticsSink {
+public:
+    explicit StreamFrameStatisticsSink(std::ostream& stream);
+    virtual ~StreamFrameStatisticsSink() = default;
+
+    StreamFrameStatisticsSink(const StreamFrameStatisticsSink& other) = delete;
+    StreamFrameStatisticsSink(StreamFrameStatisticsSink&& other) noexcept = default;
+    StreamFrameStatisticsSink& operator =(const StreamFrameStatisticsSink& other) = delete;
+    StreamFrameStatisticsSink& operator =(StreamFrameStatisticsSink&& other) noexcept = delete;
+
+    virtual void on_frame(const FrameStatistics& statistics) override;
+
+private:
+    std::ostream& m_stream;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include "SynchronousVerletIntegrator.h"
+
+void SynchronousVerletIntegrator::drift(Particle& particle, double dt, 
+        const SpatialVector& acceleration, SpatialVector& position, 
+        SpatialVector& velocity) const {
+
+    auto v_half = velocity + PositionType(0.5) * acceleration * dt;
+    position = position + v_half * dt;
+    velocity = v_half;
+}
+ 
+void SynchronousVerletIntegrator::kick(Particle& particle, double dt, 
+        const SpatialVector& end_acceleration, SpatialVector& velocity) const {
+
+    velocity = velocity + PositionType(0.5) * end_acceleration * dt;
+}
+ 
@@ -0,0 +1,28 @@
+#ifndef SYNCHRONOUSVERLETINTEGRATOR_H_
+#define SYNCHRONOUSVERLETINTEGRATOR_H_
+
+#include "IBatchMotionIntegrator.h"
+
+//Kick-drift-kick velocity Verlet where every particle is drifted before any
+//end of step force is evaluated.
+class SynchronousVerletIntegrator: public IBatchMotionIntegrator {
+public:
+    SynchronousVerletIntegrator() = default;
+    virtual ~SynchronousVerletIntegrator() = default;
+
+    SynchronousVerletIntegrator(const SynchronousVerletIntegrator& other) = delete;
+    SynchronousVerletIntegrator(SynchronousVerletIntegrator&& other) noexcept = default;
+    SynchronousVerletIntegrator& operator =(const SynchronousVerletIntegrator& other) = delete;
+    SynchronousVerletIntegrator& operator =(SynchronousVerletIntegrator&& other) noexcept = default;
+
+    virtual void drift(Particle& particle, double dt, 
+            const SpatialVector& acceleration, SpatialVector& position, 
+            SpatialVector& velocity) const override;
+
+    virtual void kick(Particle& particle, double dt, 
+            const SpatialVector& end_acceleration, 
+            SpatialVector& velocity) const override;
+
+};
+
+#endif
@@ -0,0 +1,456 @@
+#include "TextureRasterizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include "Grid.h"
+#include "Simulation.h"
+#include "SimulationRunner.h"
+#include "WorkerPool.h"
+
+namespace {
+
+bool is_signed_channel(TextureChannel channel) {
+    return channel == TextureChannel::Charge || channel == TextureChannel::VelocityX
+        || channel == TextureChannel::VelocityY;
+}
+
+//Maps [0, max] onto [0, 255], or [-max, max] for signed channels.
+unsigned char to_byte(float value, float max, bool is_signed) {
+    if(max <= 0) {
+        return is_signed ? 128 : 0;
+    }
+    auto fraction = is_signed ? 0.5f + 0.5f * value / max : value / max;
+    return static_cast<unsigned char>(
+            std::min(std::max(fraction, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+//Index of value in a periodic axis of the given size.
+long wrap_index(long value, long size) {
+    value %= size;
+    return value < 0 ? value + size : value;
+}
+
+long clamp_index(long value, long size) {
+    return std::min(std::max(value, 0L), size - 1);
+}
+
+const char* extension(TextureFormat format) {
+    switch(format) {
+    case TextureFormat::PGM: return ".pgm";
+    case TextureFormat::PPM: return ".ppm";
+    case TextureFormat::PFM: return ".pfm";
+    }
+    return "";
+}
+
+}
+
+TextureRasterizer::TextureRasterizer(std::size_t width, std::size_t height, 
+        SplatKernel kernel):
+        m_width(width), m_height(height), m_kernel(kernel),
+        m_texels(width * height) {
+    assert(width > 0 && height > 0);
+}
+ 
+TextureRasterizer::~TextureRasterizer() {
+    m_connection = nullptr;
+    if(m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_frame_ready.notify_one();
+        m_thread.join();
+    }
+}
+ 
+void TextureRasterizer::set_worker_count(std::size_t count) {
+    m_worker_count_is_set = true;
+    resize_worker_pool(count);
+}
+ 
+void TextureRasterizer::resize_worker_pool(std::size_t count) {
+    if(count <= 1) {
+        m_worker_pool = nullptr;
+    } else if(worker_count() != count) {
+        m_worker_pool = std::make_unique<WorkerPool>(count);
+    }
+}
+ 
+std::size_t TextureRasterizer::worker_count() const {
+    return m_worker_pool != nullptr ? m_worker_pool->num_workers() : 1;
+}
+ 
+void TextureRasterizer::rasterize(const Grid& grid) {
+    flush();
+    make_splats(grid, m_splats);
+    m_periodic = grid.is_periodic();
+    render();
+}
+ 
+void TextureRasterizer::make_splats(const Grid& grid, 
+        std::vector<Splat>& splats) const {
+    auto scale_x = static_cast<PositionType>(m_width) / grid.width();
+    auto scale_y = static_cast<PositionType>(m_height) / grid.height();
+    splats.clear();
+    splats.reserve(grid.num_particles());
+    for(auto& item : grid) {
+        auto& particle = item.particle();
+        auto position = particle.position();
+        auto velocity = particle.velocity();
+        splats.push_back(Splat{
+            position.x * scale_x, (grid.height() - position.y) * scale_y,
+            particle.radius() * scale_x, particle.radius() * scale_y,
+            particle.mass(), 
+            m_charge_index < particle.charge_count() 
+                ? particle.get_charge(m_charge_index) : ChargeType(0),
+            velocity.x, velocity.y
+        });
+    }
+}
+ 
+void TextureRasterizer::render() {
+    //Counting sort of the splats into every band of rows they touch.
+    auto num_bands = (m_height + BAND_ROWS - 1) / BAND_ROWS;
+    m_band_begin.assign(num_bands + 1, 0);
+    auto for_each_band = [this](const Splat& splat, auto&& fn) {
+        long first, last;
+        footprint_rows(splat, first, last);
+        auto height = static_cast<long>(m_height);
+        if(!m_periodic) {
+            for(auto band = clamp_index(first, height) / BAND_ROWS; 
+                    band <= clamp_index(last, height) / BAND_ROWS; ++band) {
+                fn(band);
+            }
+            return;
+        }
+        //Wrapped rows rise from the first band to the bottom of the image,
+        //then again from the top, stopping short of the first band unless
+        //the footprint covers every row.
+        last = std::min(last, first + height - 1);
+        auto first_band = wrap_index(first, height) / BAND_ROWS;
+        auto previous = first_band;
+        fn(first_band);
+        for(auto row = first + 1; row <= last; ++row) {
+            auto band = wrap_index(row, height) / BAND_ROWS;
+            if(band != previous && band != first_band) {
+                fn(band);
+            }
+            previous = band;
+        }
+    };
+    for(auto& splat : m_splats) {
+        for_each_band(splat, [this](std::size_t band) {++m_band_begin[band + 1];});
+    }
+    for(std::size_t band = 0; band < num_bands; ++band) {
+        m_band_begin[band + 1] += m_band_begin[band];
+    }
+    m_band_splats.resize(m_band_begin[num_bands]);
+    std::vector<std::size_t> band_end(m_band_begin.begin(), m_band_begin.end() - 1);
+    for(std::uint32_t i = 0; i < m_splats.size(); ++i) {
+        for_each_band(m_splats[i], [this, &band_end, i](std::size_t band) {
+            m_band_splats[band_end[band]++] = i;
+        });
+    }
+
+    m_column_weights.resize(worker_count());
+    auto render_bands = [this](std::size_t begin, std::size_t end, 
+            std::size_t worker) {
+        for(auto band = begin; band < end; ++band) {
+            auto row_begin = band * BAND_ROWS;
+            auto row_end = std::min(m_height, row_begin + BAND_ROWS);
+            std::fill(m_texels.begin() + row_begin * m_width, 
+                    m_texels.begin() + row_end * m_width, Texel{0, 0, 0, 0});
+            for(auto k = m_band_begin[band]; k < m_band_begin[band + 1]; ++k) {
+                splat_rows(m_splats[m_band_splats[k]], row_begin, row_end, worker);
+            }
+        }
+    };
+    if(m_worker_pool != nullptr) {
+        m_worker_pool->parallel_for(num_bands, render_bands);
+    } else {
+        render_bands(0, num_bands, 0);
+    }
+}
+ 
+void TextureRasterizer::footprint_rows(const Splat& splat, long& first, 
+        long& last) const {
+    switch(m_kernel) {
+    case SplatKernel::Point:
+        first = last = static_cast<long>(std::floor(splat.y));
+        break;
+    case SplatKernel::Bilinear:
+        first = static_cast<long>(std::floor(splat.y - PositionType(0.5)));
+        last = first + 1;
+        break;
+    case SplatKernel::Gaussian: {
+        auto reach = 3 * std::max(splat.radius_y, PositionType(0.5));
+        first = static_cast<long>(std::floor(splat.y - reach));
+        last = static_cast<long>(std::floor(splat.y + reach));
+        break;
+    }
+    }
+}
+ 
+void TextureRasterizer::splat_rows(const Splat& splat, std::size_t row_begin, 
+        std::size_t row_end, std::size_t worker) {
+    //Weights beyond the edges wrap around on a periodic grid, and are folded
+    //onto the border pixels otherwise.
+    auto width = static_cast<long>(m_width);
+    auto height = static_cast<long>(m_height);
+    auto fold = m_periodic ? wrap_index : clamp_index;
+    auto in_band = [row_begin, row_end](long row) {
+        return row >= static_cast<long>(row_begin) && row < static_cast<long>(row_end);
+    };
+
+    switch(m_kernel) {
+    case SplatKernel::Point: {
+        auto row = fold(static_cast<long>(std::floor(splat.y)), height);
+        if(in_band(row)) {
+            auto col = fold(static_cast<long>(std::floor(splat.x)), width);
+            deposit(splat, col + row * m_width, 1.0f);
+        }
+        break;
+    }
+    case SplatKernel::Bilinear: {
+        auto fx = splat.x - PositionType(0.5);
+        auto fy = splat.y - PositionType(0.5);
+        auto col0 = static_cast<long>(std::floor(fx));
+        auto row0 = static_cast<long>(std::floor(fy));
+        float tx = fx - col0;
+        float ty = fy - row0;
+        for(int j = 0; j < 2; ++j) {
+            auto row = fold(row0 + j, height);
+            if(!in_band(row)) continue;
+            auto wy = j == 0 ? 1 - ty : ty;
+            for(int i = 0; i < 2; ++i) {
+                auto col = fold(col0 + i, width);
+                auto wx = i == 0 ? 1 - tx : tx;
+                deposit(splat, col + row * m_width, wx * wy);
+            }
+        }
+        break;
+    }
+    case SplatKernel::Gaussian: {
+        auto sigma_x = std::max(splat.radius_x, PositionType(0.5));
+        auto sigma_y = std::max(splat.radius_y, PositionType(0.5));
+        auto col_first = static_cast<long>(std::floor(splat.x - 3 * sigma_x));
+        auto col_last = static_cast<long>(std::floor(splat.x + 3 * sigma_x));
+        auto row_first = static_cast<long>(std::floor(splat.y - 3 * sigma_y));
+        auto row_last = static_cast<long>(std::floor(splat.y + 3 * sigma_y));
+        auto weight = [](long pixel, PositionType center, PositionType sigma) {
+            auto d = (pixel + PositionType(0.5) - center) / sigma;
+            return static_cast<float>(std::exp(PositionType(-0.5) * d * d));
+        };
+        //The kernel is separable, and normalized over its whole footprint
+        //even though a band only deposits some of its rows.
+        auto& weights_x = m_column_weights[worker];
+        weights_x.clear();
+        float sum_x = 0;
+        for(auto col = col_first; col <= col_last; ++col) {
+            weights_x.push_back(weight(col, splat.x, sigma_x));
+            sum_x += weights_x.back();
+        }
+        float sum_y = 0;
+        for(auto row = row_first; row <= row_last; ++row) {
+            sum_y += weight(row, splat.y, sigma_y);
+        }
+        for(auto row = row_first; row <= row_last; ++row) {
+            auto target_row = fold(row, height);
+            if(!in_band(target_row)) continue;
+            auto wy = weight(row, splat.y, sigma_y) / (sum_x * sum_y);
+            auto mass = wy * static_cast<float>(splat.mass);
+            auto charge = wy * static_cast<float>(splat.charge);
+            auto momentum_x = mass * static_cast<float>(splat.vx);
+            auto momentum_y = mass * static_cast<float>(splat.vy);
+            auto texels = &m_texels[target_row * m_width];
+            for(std::size_t i = 0; i < weights_x.size(); ++i) {
+                auto& texel = texels[fold(col_first + static_cast<long>(i), width)];
+                auto wx = weights_x[i];
+                texel.mass += wx * mass;
+                texel.charge += wx * charge;
+                texel.momentum_x += wx * momentum_x;
+                texel.momentum_y += wx * momentum_y;
+            }
+        }
+        break;
+    }
+    }
+}
+ 
+float TextureRasterizer::value(TextureChannel channel, std::size_t x, 
+        std::size_t y) const {
+    assert(x < m_width && y < m_height);
+    auto& texel = m_texels[x + y * m_width];
+    auto mass = texel.mass;
+    switch(channel) {
+    case TextureChannel::Density: return mass;
+    case TextureChannel::Charge: return texel.charge;
+    case TextureChannel::VelocityX: return mass > 0 ? texel.momentum_x / mass : 0.0f;
+    case TextureChannel::VelocityY: return mass > 0 ? texel.momentum_y / mass : 0.0f;
+    case TextureChannel::Speed:
+        return mass > 0 ? std::hypot(texel.momentum_x, texel.momentum_y) / mass : 0.0f;
+    }
+    return 0.0f;
+}
+ 
+float TextureRasterizer::max_abs(TextureChannel channel) const {
+    float max = 0;
+    for(std::size_t y = 0; y < m_height; ++y) {
+        for(std::size_t x = 0; x < m_width; ++x) {
+            max = std::max(max, std::abs(value(channel, x, y)));
+        }
+    }
+    return max;
+}
+ 
+bool TextureRasterizer::write_image(const std::string& path, TextureFormat format,
+        TextureChannel channel) const {
+    char header[64];
+    std::vector<char> data;
+    switch(format) {
+    case TextureFormat::PGM: {
+        std::snprintf(header, sizeof(header), "P5\n%zu %zu\n255\n", m_width, m_height);
+        auto max = max_abs(channel);
+        auto is_signed = is_signed_channel(channel);
+        data.reserve(m_width * m_height);
+        for(std::size_t y = 0; y < m_height; ++y) {
+            for(std::size_t x = 0; x < m_width; ++x) {
+                data.push_back(to_byte(value(channel, x, y), max, is_signed));
+            }
+        }
+        break;
+    }
+    case TextureFormat::PPM: {
+        std::snprintf(header, sizeof(header), "P6\n%zu %zu\n255\n", m_width, m_height);
+        auto max_velocity = std::max(max_abs(TextureChannel::VelocityX), 
+                max_abs(TextureChannel::VelocityY));
+        auto max_density = max_abs(TextureChannel::Density);
+        data.reserve(3 * m_width * m_height);
+        for(std::size_t y = 0; y < m_height; ++y) {
+            for(std::size_t x = 0; x < m_width; ++x) {
+                data.push_back(to_byte(value(TextureChannel::VelocityX, x, y), 
+                            max_velocity, true));
+                data.push_back(to_byte(value(TextureChannel::VelocityY, x, y), 
+                            max_velocity, true));
+                data.push_back(to_byte(value(TextureChannel::Density, x, y), 
+                            max_density, false));
+            }
+        }
+        break;
+    }
+    case TextureFormat::PFM: {
+        //A negative scale marks little endian data, which is stored from the
+        //bottom row up.
+        std::snprintf(header, sizeof(header), "Pf\n%zu %zu\n-1.0\n", m_width, m_height);
+        data.resize(m_width * m_height * sizeof(float));
+        auto out = reinterpret_cast<float*>(data.data());
+        for(std::size_t y = m_height; y-- > 0;) {
+            for(std::size_t x = 0; x < m_width; ++x) {
+                *out++ = value(channel, x, y);
+            }
+        }
+        break;
+    }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(header, std::char_traits<char>::length(header));
+    file.write(data.data(), data.size());
+    file.close();
+    return !file.fail();
+}
+ 
+void TextureRasterizer::add_output(TextureFormat format, TextureChannel channel, 
+        std::string path_prefix) {
+    m_outputs.push_back(Output{format, channel, std::move(path_prefix)});
+}
+ 
+void TextureRasterizer::attach(SimulationRunner& runner, std::size_t interval) {
+    assert(interval > 0);
+    if(!m_worker_count_is_set) {
+        resize_worker_pool(runner.simulation().worker_count());
+    }
+    if(!m_thread.joinable()) {
+        m_thread = std::thread([this]() {run();});
+    }
+    m_connection = std::make_unique<ScopedEventConnection>(runner.on_frame_end(
+        [this, interval](Simulation& simulation, SimulationRunner&) {
+            auto frame = simulation.simulation_time().frame_count();
+            if(frame % interval == 0) {
+                capture(simulation.get_particles(), frame);
+            }
+        }));
+}
+ 
+void TextureRasterizer::capture(const Grid& grid, std::size_t frame) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_frame_done.wait(lock, [this]() {return !m_has_pending;});
+    }
+
+    //The render thread leaves the pending splats alone until they are
+    //published below.
+    make_splats(grid, m_pending_splats);
+    m_pending_periodic = grid.is_periodic();
+    m_pending_frame = frame;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_has_pending = true;
+    }
+    m_frame_ready.notify_one();
+}
+ 
+void TextureRasterizer::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_frame_done.wait(lock, [this]() {return !m_has_pending && !m_rendering;});
+}
+ 
+void TextureRasterizer::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true) {
+        m_frame_ready.wait(lock, [this]() {return m_stopping || m_has_pending;});
+        if(!m_has_pending) {
+            return;
+        }
+
+        m_splats.swap(m_pending_splats);
+        m_periodic = m_pending_periodic;
+        auto frame = m_pending_frame;
+        m_has_pending = false;
+        m_rendering = true;
+        lock.unlock();
+        m_frame_done.notify_all();
+
+        render();
+        auto failed = write_outputs(frame);
+
+        lock.lock();
+        m_failed_writes += failed;
+        m_rendering = false;
+        m_frame_done.notify_all();
+    }
+}
+ 
+std::size_t TextureRasterizer::write_outputs(std::size_t frame) const {
+    char number[32];
+    std::snprintf(number, sizeof(number), "%06zu", frame);
+    std::size_t failed = 0;
+    for(auto& output : m_outputs) {
+        if(!write_image(output.path_prefix + number + extension(output.format),
+                output.format, output.channel)) {
+            ++failed;
+        }
+    }
+    return failed;
+}
+ 
+std::size_t TextureRasterizer::failed_writes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failed_writes;
+}
@@ -0,0 +1,196 @@
+#ifndef PS_TEXTURE_RASTERIZER_H_
+#define PS_TEXTURE_RASTERIZER_H_
+
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CommonTypes.h"
+#include "Event.h"
+
+class Grid;
+class SimulationRunner;
+class WorkerPool;
+
+enum class SplatKernel {
+    //Everything into the pixel holding the particle's center.
+    Point,
+    //Shared between the four pixels nearest to the center.
+    Bilinear,
+    //Gaussian with the particle's radius as standard deviation, cut off at
+    //three radii.
+    Gaussian
+};
+
+enum class TextureChannel {
+    //Mass per pixel.
+    Density,
+    //Charge per pixel, of the charge index set on the rasterizer.
+    Charge,
+    //Mass weighted mean velocity.
+    VelocityX,
+    VelocityY,
+    Speed
+};
+
+enum class TextureFormat {
+    //8 bit grey of one channel, scaled to its largest value. Velocities map
+    //their range symmetrically around mid grey.
+    PGM,
+    //8 bit color with the velocity in red and green and density in blue.
+    PPM,
+    //32 bit float of one channel, unscaled.
+    PFM
+};
+
+//Renders the particles of a grid into images of any resolution. Particles
+//are splatted into float accumulation buffers, which are split into bands
+//of rows processed in parallel. Each particle is binned into the bands its
+//kernel touches, so no two workers write the same pixel and the result does
+//not depend on the number of workers. Kernels reaching past the edges of a
+//periodic grid wrap around to the opposite side.
+class TextureRasterizer {
+public:
+    TextureRasterizer(std::size_t width, std::size_t height, 
+            SplatKernel kernel = SplatKernel::Bilinear);
+    ~TextureRasterizer();
+
+    TextureRasterizer(const TextureRasterizer& other) = delete;
+    TextureRasterizer(TextureRasterizer&& other) noexcept = delete;
+    TextureRasterizer& operator =(const TextureRasterizer& other) = delete;
+    TextureRasterizer& operator =(TextureRasterizer&& other) noexcept = delete;
+
+    std::size_t width() const {return m_width;}
+    std::size_t height() const {return m_height;}
+
+    SplatKernel kernel() const {return m_kernel;}
+    void set_kernel(SplatKernel kernel) {m_kernel = kernel;}
+
+    std::size_t charge_index() const {return m_charge_index;}
+    void set_charge_index(std::size_t index) {m_charge_index = index;}
+
+    //Number of threads used for splatting, including the calling thread.
+    //Unless set, attaching uses the worker count of the simulation.
+    void set_worker_count(std::size_t count);
+    std::size_t worker_count() const;
+
+    //Waits for frames still being rendered for attached outputs first.
+    void rasterize(const Grid& grid);
+
+    //Value of a channel at a pixel of the last rasterized grid. Row 0 is the
+    //top of the image, which is the largest y of the grid.
+    float value(TextureChannel channel, std::size_t x, std::size_t y) const;
+
+    //The channel is ignored by PPM images.
+    bool write_image(const std::string& path, TextureFormat format,
+            TextureChannel channel = TextureChannel::Density) const;
+
+    //Every interval-th frame the runner completes is rasterized and written
+    //to each output, to the prefix followed by the frame count and the
+    //extension of the format. The simulation thread only copies the
+    //particles; rendering and writing happen on a thread of the rasterizer,
+    //and the simulation waits only if the previous frame is still queued.
+    //The texture is only valid to read after flush() while attached.
+    void add_output(TextureFormat format, TextureChannel channel, 
+            std::string path_prefix);
+    void attach(SimulationRunner& runner, std::size_t interval);
+    //Waits until every captured frame was rendered and written.
+    void flush();
+    //Images of attached outputs that could not be written.
+    std::size_t failed_writes() const;
+
+private:
+    struct Splat {
+        PositionType x;
+        PositionType y;
+        PositionType radius_x;
+        PositionType radius_y;
+        PositionType mass;
+        PositionType charge;
+        PositionType vx;
+        PositionType vy;
+    };
+
+    //Accumulated sums of one pixel, kept together so a deposit touches a
+    //single cache line.
+    struct Texel {
+        float mass;
+        float charge;
+        float momentum_x;
+        float momentum_y;
+    };
+
+    struct Output {
+        TextureFormat format;
+        TextureChannel channel;
+        std::string path_prefix;
+    };
+
+    void resize_worker_pool(std::size_t count);
+    void make_splats(const Grid& grid, std::vector<Splat>& splats) const;
+    void render();
+    void capture(const Grid& grid, std::size_t frame);
+    void run();
+
+    //Inclusive pixel rows touched by a splat, before folding or wrapping
+    //them into the image.
+    void footprint_rows(const Splat& splat, long& first, long& last) const;
+    void splat_rows(const Splat& splat, std::size_t row_begin, std::size_t row_end,
+            std::size_t worker);
+    void deposit(const Splat& splat, std::size_t idx, float weight) {
+        auto mass = weight * static_cast<float>(splat.mass);
+        auto& texel = m_texels[idx];
+        texel.mass += mass;
+        texel.charge += weight * static_cast<float>(splat.charge);
+        texel.momentum_x += mass * static_cast<float>(splat.vx);
+        texel.momentum_y += mass * static_cast<float>(splat.vy);
+    }
+    float max_abs(TextureChannel channel) const;
+    //Returns the number of images that could not be written.
+    std::size_t write_outputs(std::size_t frame) const;
+
+    static constexpr std::size_t BAND_ROWS = 32;
+
+    std::size_t m_width;
+    std::size_t m_height;
+    SplatKernel m_kernel;
+    std::size_t m_charge_index = 0;
+    std::unique_ptr<WorkerPool> m_worker_pool;
+    bool m_worker_count_is_set = false;
+    //Whether the splats being rendered come from a periodic grid.
+    bool m_periodic = false;
+
+    std::vector<Texel> m_texels;
+
+    //Reused between frames.
+    std::vector<Splat> m_splats;
+    std::vector<std::size_t> m_band_begin;
+    std::vector<std::uint32_t> m_band_splats;
+    //Gaussian weights of the columns of one splat, per worker.
+    std::vector<std::vector<float>> m_column_weights;
+
+    std::vector<Output> m_outputs;
+
+    //A frame captured by the simulation thread waits in the pending splats
+    //until the render thread swaps them with m_splats.
+    std::vector<Splat> m_pending_splats;
+    bool m_pending_periodic = false;
+    std::size_t m_pending_frame = 0;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_frame_ready;
+    std::condition_variable m_frame_done;
+    bool m_has_pending = false;
+    bool m_rendering = false;
+    bool m_stopping = false;
+    std::size_t m_failed_writes = 0;
+
+    std::unique_ptr<ScopedEventConnection> m_connection;
+    std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include "TrajectoryReader.h"
+
+#include <cassert>
+
+namespace {
+
+constexpr std::size_t FOOTER_SIZE = 2 * sizeof(std::uint64_t) + sizeof(std::uint32_t);
+
+}
+
+bool TrajectoryReader::open(const std::string& path) {
+    m_index.clear();
+    if(!m_file.open(path) || m_file.size() < FOOTER_SIZE) {
+        return false;
+    }
+
+    SnapshotReader reader(m_file.data(), m_file.size());
+    if(reader.read<std::uint32_t>() != TRAJECTORY_MAGIC
+            || reader.read<std::uint32_t>() != TRAJECTORY_VERSION) {
+        return false;
+    }
+    m_quantized = (reader.read<std::uint32_t>() & TRAJECTORY_QUANTIZED) != 0;
+    if(reader.read<std::uint32_t>() != sizeof(PositionType)) {
+        return false;
+    }
+
+    reader.seek(m_file.size() - FOOTER_SIZE);
+    auto num_frames = reader.read<std::uint64_t>();
+    auto index_offset = reader.read<std::uint64_t>();
+    if(reader.read<std::uint32_t>() != TRAJECTORY_INDEX_MAGIC) {
+        return false;
+    }
+    reader.seek(index_offset);
+    if(!reader.expect(num_frames, sizeof(TrajectoryIndexEntry))) {
+        return false;
+    }
+    m_index.resize(num_frames);
+    for(auto& entry : m_index) {
+        entry = reader.read<TrajectoryIndexEntry>();
+        if(entry.offset >= index_offset || entry.ids_offset > entry.offset) {
+            reader.fail();
+        }
+    }
+    if(!reader.ok()) {
+        m_index.clear();
+        return false;
+    }
+    return true;
+}
+ 
+bool TrajectoryReader::read_frame(std::size_t frame, TrajectoryFrame& out) const {
+    assert(frame < m_index.size());
+    auto& entry = m_index[frame];
+    SnapshotReader reader(m_file.data(), m_file.size());
+
+    //Frames without ids share the column of an earlier block.
+    reader.seek(entry.ids_offset);
+    reader.read<double>();
+    reader.read<std::uint64_t>();
+    auto id_count = reader.read<std::uint32_t>();
+    if(reader.read<std::uint8_t>() == 0 || !reader.expect(id_count, sizeof(int))) {
+        return false;
+    }
+    out.ids.resize(id_count);
+    reader.read_bytes(out.ids.data(), id_count * sizeof(int));
+
+    reader.seek(entry.offset);
+    out.time = reader.read<double>();
+    out.frame_count = static_cast<std::size_t>(reader.read<std::uint64_t>());
+    auto count = reader.read<std::uint32_t>();
+    if(reader.read<std::uint8_t>() != 0) {
+        reader.seek(reader.offset() + count * sizeof(int));
+    }
+    if(count != id_count) {
+        return false;
+    }
+
+    std::vector<PositionType>* columns[] = {&out.x, &out.y, &out.vx, &out.vy};
+    if(m_quantized) {
+        auto width = reader.read<PositionType>();
+        auto height = reader.read<PositionType>();
+        auto max_speed = reader.read<PositionType>();
+        if(!reader.expect(count, 4 * sizeof(std::uint16_t))) {
+            return false;
+        }
+        PositionType scales[] = {width / 65535, height / 65535, 
+            max_speed / 32767, max_speed / 32767};
+        PositionType offsets[] = {0, 0, 32768, 32768};
+        std::vector<std::uint16_t> values(count);
+        for(int c = 0; c < 4; ++c) {
+            reader.read_bytes(values.data(), count * sizeof(std::uint16_t));
+            columns[c]->resize(count);
+            for(std::size_t i = 0; i < count; ++i) {
+                (*columns[c])[i] = (values[i] - offsets[c]) * scales[c];
+            }
+        }
+    } else {
+        if(!reader.expect(count, 4 * sizeof(PositionType))) {
+            return false;
+        }
+        for(auto column : columns) {
+            column->resize(count);
+            reader.read_bytes(column->data(), count * sizeof(PositionType));
+        }
+    }
+    return reader.ok();
+}
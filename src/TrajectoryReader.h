@@ -0,0 +1,49 @@
+#ifndef PS_TRAJECTORY_READER_H_
+#define PS_TRAJECTORY_READER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommonTypes.h"
+#include "SimulationSnapshot.h"
+#include "TrajectoryWriter.h"
+
+struct TrajectoryFrame {
+    double time = 0.0;
+    std::size_t frame_count = 0;
+    std::vector<int> ids;
+    std::vector<PositionType> x;
+    std::vector<PositionType> y;
+    std::vector<PositionType> vx;
+    std::vector<PositionType> vy;
+};
+
+//Random access to the frames of a file written by TrajectoryWriter, found
+//through the index at the end of the file.
+class TrajectoryReader {
+public:
+    TrajectoryReader() = default;
+    ~TrajectoryReader() = default;
+
+    TrajectoryReader(const TrajectoryReader& other) = delete;
+    TrajectoryReader(TrajectoryReader&& other) noexcept = delete;
+    TrajectoryReader& operator =(const TrajectoryReader& other) = delete;
+    TrajectoryReader& operator =(TrajectoryReader&& other) noexcept = delete;
+
+    //Fails for files that were not closed, since they have no index.
+    bool open(const std::string& path);
+
+    bool is_quantized() const {return m_quantized;}
+    std::size_t num_frames() const {return m_index.size();}
+    double frame_time(std::size_t frame) const {return m_index[frame].time;}
+
+    bool read_frame(std::size_t frame, TrajectoryFrame& out) const;
+
+private:
+    MappedFile m_file;
+    bool m_quantized = false;
+    std::vector<TrajectoryIndexEntry> m_index;
+};
+
+#endif
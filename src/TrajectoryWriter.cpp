@@ -0,0 +1,132 @@
+#include "TrajectoryWriter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Simulation.h"
+#include "SimulationRunner.h"
+
+TrajectoryWriter::TrajectoryWriter(const std::string& path, bool quantize):
+        m_file(path, std::ios::binary | std::ios::trunc), m_quantize(quantize) {
+    SnapshotWriter header;
+    header.write(TRAJECTORY_MAGIC);
+    header.write(TRAJECTORY_VERSION);
+    header.write(quantize ? TRAJECTORY_QUANTIZED : std::uint32_t(0));
+    header.write(static_cast<std::uint32_t>(sizeof(PositionType)));
+    m_file.write(header.buffer().data(), header.buffer().size());
+    m_offset = header.buffer().size();
+}
+ 
+TrajectoryWriter::~TrajectoryWriter() {
+    if(is_open()) {
+        close();
+    }
+}
+ 
+void TrajectoryWriter::attach(SimulationRunner& runner) {
+    m_connection = std::make_unique<ScopedEventConnection>(runner.on_frame_end(
+        [this](Simulation& simulation, SimulationRunner&) {
+            write_frame(simulation);
+        }));
+}
+ 
+void TrajectoryWriter::write_frame(const Simulation& simulation) {
+    if(!is_open()) {
+        return;
+    }
+
+    auto& grid = simulation.get_particles();
+    auto count = grid.num_particles();
+    m_ids.resize(count);
+    for(auto& column : m_columns) {
+        column.resize(count);
+    }
+    std::size_t i = 0;
+    for(auto& item : grid) {
+        auto& particle = item.particle();
+        m_ids[i] = particle.id();
+        m_columns[0][i] = particle.position().x;
+        m_columns[1][i] = particle.position().y;
+        m_columns[2][i] = particle.velocity().x;
+        m_columns[3][i] = particle.velocity().y;
+        ++i;
+    }
+
+    auto time = simulation.simulation_time().current_simulation_time();
+    auto write_ids = m_index.empty() || m_ids != m_previous_ids;
+    if(write_ids) {
+        m_ids_offset = m_offset;
+    }
+
+    m_block.clear();
+    m_block.write(time);
+    m_block.write(static_cast<std::uint64_t>(simulation.simulation_time().frame_count()));
+    m_block.write(static_cast<std::uint32_t>(count));
+    m_block.write(static_cast<std::uint8_t>(write_ids));
+    if(write_ids) {
+        m_block.write_bytes(m_ids.data(), count * sizeof(int));
+        m_previous_ids.swap(m_ids);
+    }
+    if(m_quantize) {
+        PositionType max_speed = 0;
+        for(int c = 2; c < 4; ++c) {
+            for(auto value : m_columns[c]) {
+                max_speed = std::max(max_speed, std::abs(value));
+            }
+        }
+        m_block.write(grid.width());
+        m_block.write(grid.height());
+        m_block.write(max_speed);
+        write_columns(grid.width(), grid.height(), max_speed);
+    } else {
+        for(auto& column : m_columns) {
+            m_block.write_bytes(column.data(), count * sizeof(PositionType));
+        }
+    }
+
+    auto& buffer = m_block.buffer();
+    m_file.write(buffer.data(), buffer.size());
+    m_index.push_back(TrajectoryIndexEntry{m_offset, m_ids_offset, time});
+    m_offset += buffer.size();
+}
+ 
+void TrajectoryWriter::write_columns(PositionType width, PositionType height,
+        PositionType max_speed) {
+    auto count = m_columns[0].size();
+    m_quantized.resize(count);
+    //Positions map [0, extent] onto [0, 65535], and velocities map
+    //[-max_speed, max_speed] onto [1, 65535] centered on 32768.
+    auto write_column = [this, count](const std::vector<PositionType>& column,
+            PositionType scale, PositionType offset) {
+        for(std::size_t i = 0; i < count; ++i) {
+            auto value = column[i] * scale + offset;
+            //Rounds by truncation, since value is clamped to be positive.
+            m_quantized[i] = static_cast<std::uint16_t>(PositionType(0.5)
+                    + std::min(std::max(value, PositionType(0)), PositionType(65535)));
+        }
+        m_block.write_bytes(m_quantized.data(), count * sizeof(std::uint16_t));
+    };
+    auto velocity_scale = max_speed > 0 ? 32767 / max_speed : PositionType(0);
+    write_column(m_columns[0], 65535 / width, 0);
+    write_column(m_columns[1], 65535 / height, 0);
+    write_column(m_columns[2], velocity_scale, 32768);
+    write_column(m_columns[3], velocity_scale, 32768);
+}
+ 
+bool TrajectoryWriter::close() {
+    m_connection = nullptr;
+    if(!is_open()) {
+        return false;
+    }
+
+    m_block.clear();
+    for(auto& entry : m_index) {
+        m_block.write(entry);
+    }
+    m_block.write(static_cast<std::uint64_t>(m_index.size()));
+    m_block.write(m_offset);
+    m_block.write(TRAJECTORY_INDEX_MAGIC);
+    m_file.write(m_block.buffer().data(), m_block.buffer().size());
+    m_file.close();
+    return !m_file.fail();
+}
@@ -0,0 +1,77 @@
+#ifndef PS_TRAJECTORY_WRITER_H_
+#define PS_TRAJECTORY_WRITER_H_
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CommonTypes.h"
+#include "Event.h"
+#include "SimulationSnapshot.h"
+
+class Simulation;
+class SimulationRunner;
+
+constexpr std::uint32_t TRAJECTORY_MAGIC = 0x50535454;
+constexpr std::uint32_t TRAJECTORY_INDEX_MAGIC = 0x50535449;
+constexpr std::uint32_t TRAJECTORY_VERSION = 1;
+constexpr std::uint32_t TRAJECTORY_QUANTIZED = 1;
+
+//One entry of the frame index at the end of a trajectory file.
+struct TrajectoryIndexEntry {
+    std::uint64_t offset;
+    //Block holding the id column that applies to this frame.
+    std::uint64_t ids_offset;
+    double time;
+};
+
+//Appends frames to a binary trajectory file. Each frame is one block of
+//columns: particle ids, x, y, vx and vy. The id column is left out while the
+//particles and their order are unchanged since the previous frame. Quantized
+//files store positions as 16 bit fractions of the grid and velocities as 16
+//bit fractions of the fastest component in the frame. Closing the file
+//appends an index of the blocks for random access.
+class TrajectoryWriter {
+public:
+    explicit TrajectoryWriter(const std::string& path, bool quantize = false);
+    ~TrajectoryWriter();
+
+    TrajectoryWriter(const TrajectoryWriter& other) = delete;
+    TrajectoryWriter(TrajectoryWriter&& other) noexcept = delete;
+    TrajectoryWriter& operator =(const TrajectoryWriter& other) = delete;
+    TrajectoryWriter& operator =(TrajectoryWriter&& other) noexcept = delete;
+
+    bool is_open() const {return m_file.is_open();}
+    bool is_quantized() const {return m_quantize;}
+    std::size_t num_frames() const {return m_index.size();}
+
+    //Writes every frame the runner completes until the writer is closed.
+    void attach(SimulationRunner& runner);
+
+    void write_frame(const Simulation& simulation);
+    //Writes the frame index and closes the file. Returns false if any write
+    //failed.
+    bool close();
+
+private:
+    void write_columns(PositionType width, PositionType height, 
+            PositionType max_speed);
+
+    std::ofstream m_file;
+    bool m_quantize;
+    std::uint64_t m_offset = 0;
+    std::uint64_t m_ids_offset = 0;
+    std::vector<TrajectoryIndexEntry> m_index;
+    std::unique_ptr<ScopedEventConnection> m_connection;
+
+    //Reused between frames.
+    SnapshotWriter m_block;
+    std::vector<int> m_ids;
+    std::vector<int> m_previous_ids;
+    std::vector<PositionType> m_columns[4];
+    std::vector<std::uint16_t> m_quantized;
+};
+
+#endif
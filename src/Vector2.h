@@ -15,6 +15,8 @@ public:
     ~Vector2() = default;
 
     constexpr Vector2(T x_val, T y_val);
+    template<typename U>
+    constexpr explicit Vector2(const Vector2<U>& other);
 
     constexpr Vector2(const Vector2& lhs) = default;
     constexpr Vector2(Vector2&& lhs) noexcept = default;
@@ -76,6 +78,13 @@ inline constexpr Vector2<T>::Vector2():
 {
 }
  
+template<typename T>
+template<typename U>
+inline constexpr Vector2<T>::Vector2(const Vector2<U>& other):
+    x(static_cast<T>(other.x)), y(static_cast<T>(other.y))
+{
+}
+ 
 template<typename T>
 inline constexpr Vector2<T>::Vector2(T x_val, T y_val):
    x(x_val), y(y_val) 
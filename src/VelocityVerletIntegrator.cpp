@@ -13,5 +13,9 @@ void VelocityVerletIntegrator::advance_motion(Simulation& simulation,
     auto a_end = simulation.compute_acceleration(particle, position, velocity);
     auto v = v_half + PositionType(0.5)*a_end*dt;
     velocity = v;
+
+    if(m_reuse_end_acceleration) {
+        particle.cache_next_acceleration(a_end);
+    }
 }
  
@@ -5,7 +5,8 @@
 
 class VelocityVerletIntegrator: public IMotionIntegrator {
 public:
-    VelocityVerletIntegrator() = default;
+    VelocityVerletIntegrator(bool reuse_end_acceleration = false):
+        m_reuse_end_acceleration(reuse_end_acceleration) {}
     virtual ~VelocityVerletIntegrator() = default;
 
     VelocityVerletIntegrator(const VelocityVerletIntegrator& other) = delete;
@@ -16,6 +17,22 @@ public:
     virtual void advance_motion(Simulation& simulation, 
             Particle& particle, double dt, const SpatialVector& acceleration, 
             SpatialVector& position, SpatialVector& velocity) const override;
+
+    //Off by default. When enabled, the end of step acceleration is kept on
+    //the particle and reused as the next frame's starting acceleration, so
+    //each frame costs one force evaluation per particle instead of two.
+    //That acceleration is evaluated while the other particles are still at
+    //their start of step positions, so reusing it changes the trajectory by
+    //an error of first order in dt. SynchronousVerletIntegrator reuses end
+    //of step forces without changing the result.
+    virtual bool caches_end_acceleration() const override {
+        return m_reuse_end_acceleration;
+    }
+    bool reuse_end_acceleration() const {return m_reuse_end_acceleration;}
+    void set_reuse_end_acceleration(bool value) {m_reuse_end_acceleration = value;}
+
+private:
+    bool m_reuse_end_acceleration = false;
 };
 
 #endif
@@ -0,0 +1,107 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+WorkerPool::WorkerPool(std::size_t num_workers) {
+    assert(num_workers > 0);
+    for(std::size_t i = 1; i < num_workers; ++i) {
+        m_threads.emplace_back(&WorkerPool::worker_main, this, i);
+    }
+}
+ 
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_start_condition.notify_all();
+    for(auto& thread : m_threads) {
+        thread.join();
+    }
+}
+ 
+void WorkerPool::parallel_for(std::size_t count, const RangeFn& fn) {
+    //Several chunks per worker keeps the load balanced when the cost per
+    //index varies, as it does for grid cells.
+    auto chunk_size = std::max<std::size_t>(1, count / (num_workers() * 8));
+    dispatch(count, chunk_size, false, fn);
+}
+ 
+void WorkerPool::parallel_for_static(std::size_t count, const RangeFn& fn) {
+    auto chunk_size = std::max<std::size_t>(1, 
+            (count + num_workers() - 1) / num_workers());
+    dispatch(count, chunk_size, true, fn);
+}
+ 
+void WorkerPool::dispatch(std::size_t count, std::size_t chunk_size, 
+        bool is_static, const RangeFn& fn) {
+    if(count == 0) {
+        return;
+    }
+    if(m_threads.empty() || count <= chunk_size) {
+        fn(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &fn;
+        m_count = count;
+        m_chunk_size = chunk_size;
+        m_is_static = is_static;
+        m_next_index.store(0, std::memory_order_relaxed);
+        m_active_workers = m_threads.size();
+        m_generation += 1;
+    }
+    m_start_condition.notify_all();
+
+    run_chunks(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_condition.wait(lock, [this]() {return m_active_workers == 0;});
+    m_job = nullptr;
+}
+ 
+void WorkerPool::worker_main(std::size_t worker_index) {
+    std::size_t seen_generation = 0;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start_condition.wait(lock, [this, seen_generation]() {
+                return m_shutdown || m_generation != seen_generation;
+            });
+            if(m_shutdown) {
+                return;
+            }
+            seen_generation = m_generation;
+        }
+
+        run_chunks(worker_index);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_active_workers -= 1;
+        }
+        m_done_condition.notify_one();
+    }
+}
+ 
+void WorkerPool::run_chunks(std::size_t worker_index) {
+    if(m_is_static) {
+        auto begin = worker_index * m_chunk_size;
+        if(begin < m_count) {
+            (*m_job)(begin, std::min(begin + m_chunk_size, m_count), worker_index);
+        }
+        return;
+    }
+
+    while(true) {
+        auto begin = m_next_index.fetch_add(m_chunk_size);
+        if(begin >= m_count) {
+            return;
+        }
+        auto end = std::min(begin + m_chunk_size, m_count);
+        (*m_job)(begin, end, worker_index);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef PS_WORKER_POOL_H_
+#define PS_WORKER_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//A fixed set of persistent worker threads for data parallel loops. The
+//calling thread takes part in every loop as worker 0.
+class WorkerPool {
+public:
+    //fn(begin, end, worker_index) processes the index range [begin, end).
+    using RangeFn = std::function<void (std::size_t, std::size_t, std::size_t)>;
+
+    explicit WorkerPool(std::size_t num_workers);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool& other) = delete;
+    WorkerPool(WorkerPool&& other) noexcept = delete;
+    WorkerPool& operator =(const WorkerPool& other) = delete;
+    WorkerPool& operator =(WorkerPool&& other) noexcept = delete;
+
+    std::size_t num_workers() const {return m_threads.size() + 1;}
+
+    //Splits [0, count) into chunks that are handed out to the workers on
+    //demand, and returns once every chunk has been processed.
+    void parallel_for(std::size_t count, const RangeFn& fn);
+
+    //As parallel_for, but each worker receives exactly one contiguous slice.
+    void parallel_for_static(std::size_t count, const RangeFn& fn);
+
+private:
+    void worker_main(std::size_t worker_index);
+    void run_chunks(std::size_t worker_index);
+    void dispatch(std::size_t count, std::size_t chunk_size, bool is_static,
+            const RangeFn& fn);
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start_condition;
+    std::condition_variable m_done_condition;
+
+    const RangeFn* m_job = nullptr;
+    std::size_t m_count = 0;
+    std::size_t m_chunk_size = 1;
+    bool m_is_static = false;
+    std::atomic<std::size_t> m_next_index{0};
+    std::size_t m_generation = 0;
+    std::size_t m_active_workers = 0;
+    bool m_shutdown = false;
+};
+
+#endif
@@ -22,7 +22,7 @@ int main(int argc, char** argv) {
     std::ios_base::sync_with_stdio(false);
     std::setvbuf(stdout, nullptr, _IOFBF, BUFSIZ);
 
-    Grid grid(10, 10, 10, 10);
+    Simulation::SpatialContainer grid(10, 10, 10, 10);
 
     auto rng = std::mt19937();
 
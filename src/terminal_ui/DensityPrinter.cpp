@@ -57,7 +57,7 @@ void ParticleDensityBuilder::build_density_grid(std::vector<double>& density_gri
 
     for(auto& p : grid) {
         total_density += 1;
-        auto& particle = p.second->particle();
+        auto& particle = p.particle();
 
         if(printer.is_in_grid(particle.position())) {
             auto idx = printer.position_to_grid_idx(particle.position());
@@ -24,7 +24,7 @@ std::vector<GridCell> ParticlePrinter::build_format_grid(const Grid& grid) const
     std::vector<GridCell> format_grid(width()*height());
 
     for(auto& p : grid) {
-        auto& particle = p.second->particle();
+        auto& particle = p.particle();
         if(m_particle_colors.find(particle.id()) == m_particle_colors.end()) {
             m_particle_colors.insert(std::make_pair(
                         particle.id(), static_cast<int>(m_particle_colors.size())));
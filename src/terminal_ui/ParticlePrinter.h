@@ -26,7 +26,7 @@ public:
     ~GridCell() = default;
 
     CellType type = CellType::Empty;
-    Particle* particle = nullptr;
+    const Particle* particle = nullptr;
     term::TerminalColor bg;
 };
 
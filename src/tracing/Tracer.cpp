@@ -52,7 +52,7 @@ void Tracer::enable_particle_tracing(const Particle& particle) {
 }
 void Tracer::enable_particle_tracing(int id) {
     m_active_particles.insert(id);
-    m_last_particle = nullptr;
+    m_last_particle = -1;
 }
 void Tracer::enable_particle_tracing(const std::vector<int>& ids) {
     for(auto id : ids) {
@@ -70,7 +70,7 @@ void Tracer::disable_particle_tracing(const Particle& particle) {
 }
 void Tracer::disable_particle_tracing(int id) {
     m_active_particles.erase(id); 
-    m_last_particle = nullptr;
+    m_last_particle = -1;
 }
 void Tracer::disable_particle_tracing(const std::vector<int>& ids) {
     for(auto id : ids) {
@@ -67,14 +67,14 @@ public:
 private:
     std::vector<std::unique_ptr<ITracerSink>> m_sinks;
     std::unordered_set<int> m_active_particles;
-    mutable const Particle* m_last_particle = nullptr;
+    mutable int m_last_particle = -1;
     mutable bool m_last_active = false;
 };
 
 inline bool Tracer::is_particle_active(const Particle& particle) const {
-    if(m_last_particle != &particle) {
+    if(m_last_particle != particle.id()) {
         m_last_active = m_active_particles.find(particle.id()) != m_active_particles.end(); 
-        m_last_particle = &particle;
+        m_last_particle = particle.id();
         return m_last_active;
     } else {
         return m_last_active;